@@ -219,30 +219,19 @@ int main(int argc, char* argv[])
         }
     }
 
-    // If the kernel was not available, then light up the plugins and retry
-    if (!isValidKernel)
-    {
-        KernelFactory f(false);
-        loaded_kernels.clear();
-        loaded_kernels = f.getKernelNames();
-
-        for (auto name : loaded_kernels)
-        {
-            if (boost::iequals(argv[1], splitDriverName(name)))
-            {
-                fullname = name;
-                isValidKernel = true;
-                break;
-            }
-        }
-    }
+    // If the kernel was not available, look for a plugin that provides it.
+    // The plugin manifest is used so that only that plugin is loaded.
+    std::unique_ptr<Kernel> app;
+    if (isValidKernel)
+        app = f.createKernel(fullname);
+    else if (!boost::starts_with(command, "-"))
+        app = f.createKernel("kernels." + boost::to_lower_copy(command));
 
     // Dispatch execution to the kernel, passing all remaining args
-    if (isValidKernel)
+    if (app)
     {
         int count(argc - 1); // remove the 1st argument
         const char** args = const_cast<const char**>(&argv[1]);
-        std::unique_ptr<Kernel> app = f.createKernel(fullname);
         return app->run(count, args, command);
     }
 
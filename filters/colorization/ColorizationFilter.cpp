@@ -36,6 +36,7 @@
 
 #include <pdal/GlobalEnvironment.hpp>
 #include <pdal/PointView.hpp>
+#include <pdal/Trace.hpp>
 
 #include <gdal.h>
 #include <ogr_spatialref.h>
@@ -187,6 +188,7 @@ void ColorizationFilter::filter(PointView& view)
     int32_t line(0);
 
     std::array<double, 2> pix = { {0.0, 0.0} };
+    TraceScope trace("gdal", "filters.colorization raster read");
     for (PointId idx = 0; idx < view.size(); ++idx)
     {
         double x = view.getFieldAs<double>(Dimension::Id::X, idx);
@@ -78,6 +78,10 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
+    virtual bool pointwise() const
+        { return true; }
 
     Options getDefaultOptions();
 
@@ -37,7 +37,9 @@
 #include <pdal/PointView.hpp>
 #include <pdal/StageFactory.hpp>
 #include <pdal/GDALUtils.hpp>
+#include <pdal/Trace.hpp>
 
+#include <limits>
 #include <sstream>
 #include <cstdarg>
 
@@ -190,6 +192,28 @@ GEOSGeometry *CropFilter::validatePolygon(const std::string& poly)
 }
 
 
+BOX2D CropFilter::computeBounds(GEOSGeometry const *geometry) const
+{
+    BOX2D bounds;
+
+    GEOSGeometry *env = GEOSEnvelope_r(m_geosEnvironment, geometry);
+    const GEOSGeometry *ring = GEOSGetExteriorRing_r(m_geosEnvironment, env);
+    const GEOSCoordSequence *coords =
+        GEOSGeom_getCoordSeq_r(m_geosEnvironment, ring);
+    unsigned int size = 0;
+    GEOSCoordSeq_getSize_r(m_geosEnvironment, coords, &size);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        double x, y;
+        GEOSCoordSeq_getX_r(m_geosEnvironment, coords, i, &x);
+        GEOSCoordSeq_getY_r(m_geosEnvironment, coords, i, &y);
+        bounds.grow(x, y);
+    }
+    GEOSGeom_destroy_r(m_geosEnvironment, env);
+    return bounds;
+}
+
+
 void CropFilter::preparePolygon(GeomPkg& g, const SpatialReference& to)
 {
     char* out_wkt = GEOSGeomToWKT_r(m_geosEnvironment, g.m_geom);
@@ -223,6 +247,51 @@ Options CropFilter::getDefaultOptions()
 }
 
 
+bool CropFilter::usedDimensions(StringList& dims) const
+{
+    dims.push_back("X");
+    dims.push_back("Y");
+    // Points are cropped against polygons in three dimensions.
+    if (m_polys.size())
+        dims.push_back("Z");
+    return true;
+}
+
+
+// Points outside all of the boxes and polygons are dropped.  Polygons
+// given in another spatial reference aren't transformed until the
+// stage is ready, so there are no bounds if there are any.
+bool CropFilter::cropBounds(BOX3D& bounds) const
+{
+    if (m_cropOutside || (m_bounds.empty() && m_polys.empty()))
+        return false;
+
+    BOX2D box;
+    for (auto& b : m_bounds)
+        box.grow(b);
+#ifdef PDAL_HAVE_GEOS
+    if (m_geoms.size() && !m_assignedSRS.empty())
+        return false;
+    for (const auto& g : m_geoms)
+        box.grow(computeBounds(g.m_geom));
+#endif
+
+    bounds = BOX3D(box.minx, box.miny,
+        (std::numeric_limits<double>::lowest)(), box.maxx, box.maxy,
+        (std::numeric_limits<double>::max)());
+    return true;
+}
+
+
+bool CropFilter::processOne(PointView& view, PointId idx)
+{
+    double x = view.getFieldAs<double>(Dimension::Id::X, idx);
+    double y = view.getFieldAs<double>(Dimension::Id::Y, idx);
+
+    return m_cropOutside != m_bounds.front().contains(x, y);
+}
+
+
 PointViewSet CropFilter::run(PointViewPtr view)
 {
     PointViewSet viewSet;
@@ -237,31 +306,25 @@ PointViewSet CropFilter::run(PointViewPtr view)
 #ifdef PDAL_HAVE_GEOS
     for (const auto& geom : m_geoms)
     {
-        PointViewPtr outView = view->makeNew();
-        crop(geom, *view, *outView);
-        viewSet.insert(outView);
+        viewSet.insert(crop(geom, *view));
     }
 #endif
     for (auto& box : m_bounds)
     {
-        PointViewPtr outView = view->makeNew();
-        crop(box, *view, *outView);
-        viewSet.insert(outView);
+        viewSet.insert(crop(box, *view));
     }
     return viewSet;
 }
 
-void CropFilter::crop(const BOX2D& box, PointView& input, PointView& output)
+PointViewPtr CropFilter::crop(const BOX2D& box, const PointView& input)
 {
-    for (PointId idx = 0; idx < input.size(); ++idx)
+    return input.select([this, &box, &input](PointId idx)
     {
         double x = input.getFieldAs<double>(Dimension::Id::X, idx);
         double y = input.getFieldAs<double>(Dimension::Id::Y, idx);
 
-        bool contained = box.contains(x, y);
-        if (m_cropOutside != box.contains(x, y))
-            output.appendPoint(input, idx);
-    }
+        return m_cropOutside != box.contains(x, y);
+    });
 }
 
 #ifdef PDAL_HAVE_GEOS
@@ -286,13 +349,14 @@ GEOSGeometry *CropFilter::createPoint(double x, double y, double z)
 
 
 
-void CropFilter::crop(const GeomPkg& g, PointView& input, PointView& output)
+PointViewPtr CropFilter::crop(const GeomPkg& g, const PointView& input)
 {
     bool logOutput = (log()->getLevel() > LogLevel::Debug4);
     if (logOutput)
         log()->floatPrecision(8);
 
-    for (PointId idx = 0; idx < input.size(); ++idx)
+    TraceScope trace("geos", "filters.crop polygon test");
+    return input.select([this, &g, &input, logOutput](PointId idx)
     {
         double x = input.getFieldAs<double>(Dimension::Id::X, idx);
         double y = input.getFieldAs<double>(Dimension::Id::Y, idx);
@@ -308,10 +372,9 @@ void CropFilter::crop(const GeomPkg& g, PointView& input, PointView& output)
         GEOSGeometry *p = createPoint(x, y, z);
         bool covers = (bool)(GEOSPreparedCovers_r(m_geosEnvironment,
             g.m_prepGeom, p));
-        if (m_cropOutside != covers)
-            output.appendPoint(input, idx);
         GEOSGeom_destroy_r(m_geosEnvironment, p);
-    }
+        return m_cropOutside != covers;
+    });
 }
 #endif
 
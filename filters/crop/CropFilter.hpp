@@ -56,6 +56,20 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
+    // GEOS geometries are shared by all views, so polygon crops are run
+    // one view at a time.
+    virtual bool parallelizable() const
+        { return m_geoms.empty(); }
+    virtual bool usedDimensions(StringList& dims) const;
+    virtual bool cropBounds(BOX3D& bounds) const;
+    virtual bool pointwise() const
+        { return true; }
+    // A crop to a single box makes a single view, so it can be fused.
+    virtual bool fusable() const
+        { return m_geoms.empty() && m_bounds.size() == 1; }
+    virtual bool processOne(PointView& view, PointId idx);
 
     Options getDefaultOptions();
 
@@ -84,12 +98,12 @@ private:
     virtual void ready(PointTableRef table);
     virtual PointViewSet run(PointViewPtr view);
     virtual void done(PointTableRef table);
-    void crop(const BOX2D& box, PointView& input, PointView& output);
-    void crop(const GeomPkg& g, PointView& input, PointView& output);
+    PointViewPtr crop(const BOX2D& box, const PointView& input);
+    PointViewPtr crop(const GeomPkg& g, const PointView& input);
 #ifdef PDAL_HAVE_GEOS
     GEOSGeometry *validatePolygon(const std::string& poly);
     void preparePolygon(GeomPkg& g, const SpatialReference& to);
-    BOX2D computeBounds(GEOSGeometry const *geometry);
+    BOX2D computeBounds(GEOSGeometry const *geometry) const;
     GEOSGeometry *createPoint(double x, double y, double z);
 #endif
 
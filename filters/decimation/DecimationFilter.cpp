@@ -59,18 +59,19 @@ void DecimationFilter::processOptions(const Options& options)
 PointViewSet DecimationFilter::run(PointViewPtr inView)
 {
     PointViewSet viewSet;
-    PointViewPtr outView = inView->makeNew();
-    decimate(*inView.get(), *outView.get());
-    viewSet.insert(outView);
+    viewSet.insert(decimate(*inView));
     return viewSet;
 }
 
 
-void DecimationFilter::decimate(PointView& input, PointView& output)
+PointViewPtr DecimationFilter::decimate(const PointView& input)
 {
     PointId last_idx = (m_limit > 0) ? m_limit : input.size();
-    for (PointId idx = m_offset; idx < last_idx; idx += m_step)
-        output.appendPoint(input, idx);
+    return input.select([this, last_idx](PointId idx)
+    {
+        return idx >= m_offset && idx < last_idx &&
+            (idx - m_offset) % m_step == 0;
+    });
 }
 
 } // pdal
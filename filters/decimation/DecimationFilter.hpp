@@ -52,6 +52,10 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool parallelizable() const
+        { return true; }
+    virtual bool usedDimensions(StringList& /*dims*/) const
+        { return true; }
 
 private:
     uint32_t m_step;
@@ -60,7 +64,7 @@ private:
 
     virtual void processOptions(const Options& options);
     PointViewSet run(PointViewPtr view);
-    void decimate(PointView& input, PointView& output);
+    PointViewPtr decimate(const PointView& input);
 
     DecimationFilter& operator=(const DecimationFilter&); // not implemented
     DecimationFilter(const DecimationFilter&); // not implemented
@@ -54,6 +54,13 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
+    virtual bool parallelizable() const
+        { return true; }
+    virtual bool fusable() const
+        { return true; }
+    virtual bool processOne(PointView& view, PointId idx);
 
     Options getDefaultOptions();
 
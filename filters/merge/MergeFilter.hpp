@@ -51,6 +51,10 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool usedDimensions(StringList& /*dims*/) const
+        { return true; }
+    virtual bool pointwise() const
+        { return true; }
 
 private:
     PointViewPtr m_view;
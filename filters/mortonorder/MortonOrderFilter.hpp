@@ -51,6 +51,13 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool parallelizable() const
+        { return true; }
+    virtual bool usedDimensions(StringList& dims) const
+    {
+        dims.insert(dims.end(), { "X", "Y" });
+        return true;
+    }
 
     Options getDefaultOptions();
 
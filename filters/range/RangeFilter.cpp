@@ -96,31 +96,61 @@ void RangeFilter::ready(PointTableRef table)
     }
 }
 
-PointViewSet RangeFilter::run(PointViewPtr inView)
+// Ranges of X, Y and Z limit the bounds of the points that are kept.
+bool RangeFilter::cropBounds(BOX3D& bounds) const
 {
-    PointViewSet viewSet;
-    if (!inView->size())
-        return viewSet;
-
-    PointViewPtr outView = inView->makeNew();
+    const double lowest = (std::numeric_limits<double>::lowest)();
+    const double highest = (std::numeric_limits<double>::max)();
 
-    for (PointId i = 0; i < inView->size(); ++i)
+    bool limited = false;
+    bounds = BOX3D(lowest, lowest, lowest, highest, highest, highest);
+    for (auto const& r : m_name_map)
     {
-        bool keep_point = true;
-        for (auto const& d : m_dimensions_map)
+        const Range& range = r.second;
+        switch (Dimension::id(r.first))
         {
-            double v = inView->getFieldAs<double>(d.first, i);
-            if (v < d.second.min || v > d.second.max)
-            {
-                keep_point = false;
-                break;
-            }
+        case Dimension::Id::X:
+            bounds.minx = range.min;
+            bounds.maxx = range.max;
+            break;
+        case Dimension::Id::Y:
+            bounds.miny = range.min;
+            bounds.maxy = range.max;
+            break;
+        case Dimension::Id::Z:
+            bounds.minz = range.min;
+            bounds.maxz = range.max;
+            break;
+        default:
+            continue;
         }
-        if (keep_point)
-            outView->appendPoint(*inView, i);
+        limited = true;
     }
+    return limited;
+}
+
+
+bool RangeFilter::processOne(PointView& view, PointId idx)
+{
+    for (auto const& d : m_dimensions_map)
+    {
+        double v = view.getFieldAs<double>(d.first, idx);
+        if (v < d.second.min || v > d.second.max)
+            return false;
+    }
+    return true;
+}
+
+
+PointViewSet RangeFilter::run(PointViewPtr inView)
+{
+    PointViewSet viewSet;
+    if (!inView->size())
+        return viewSet;
 
-    viewSet.insert(outView);
+    PointView& view = *inView;
+    viewSet.insert(view.select([this, &view](PointId i)
+        { return processOne(view, i); }));
 
     return viewSet;
 }
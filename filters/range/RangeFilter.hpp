@@ -63,6 +63,22 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
+    virtual bool parallelizable() const
+        { return true; }
+    virtual bool usedDimensions(StringList& dims) const
+    {
+        for (auto const& r : m_name_map)
+            dims.push_back(r.first);
+        return true;
+    }
+    virtual bool cropBounds(BOX3D& bounds) const;
+    virtual bool pointwise() const
+        { return true; }
+    virtual bool fusable() const
+        { return true; }
+    virtual bool processOne(PointView& view, PointId idx);
 
 private:
     std::map<std::string, Range> m_name_map;
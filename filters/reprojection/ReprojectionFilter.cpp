@@ -175,20 +175,25 @@ void ReprojectionFilter::transform(double& x, double& y, double& z)
 }
 
 
-void ReprojectionFilter::filter(PointView& view)
+bool ReprojectionFilter::processOne(PointView& view, PointId id)
 {
-    for (PointId id = 0; id < view.size(); ++id)
-    {
-        double x = view.getFieldAs<double>(Dimension::Id::X, id);
-        double y = view.getFieldAs<double>(Dimension::Id::Y, id);
-        double z = view.getFieldAs<double>(Dimension::Id::Z, id);
+    double x = view.getFieldAs<double>(Dimension::Id::X, id);
+    double y = view.getFieldAs<double>(Dimension::Id::Y, id);
+    double z = view.getFieldAs<double>(Dimension::Id::Z, id);
 
-        transform(x, y, z);
+    transform(x, y, z);
 
-        view.setField(Dimension::Id::X, id, x);
-        view.setField(Dimension::Id::Y, id, y);
-        view.setField(Dimension::Id::Z, id, z);
-    }
+    view.setField(Dimension::Id::X, id, x);
+    view.setField(Dimension::Id::Y, id, y);
+    view.setField(Dimension::Id::Z, id, z);
+    return true;
+}
+
+
+void ReprojectionFilter::filter(PointView& view)
+{
+    for (PointId id = 0; id < view.size(); ++id)
+        processOne(view, id);
 }
 
 } // namespace pdal
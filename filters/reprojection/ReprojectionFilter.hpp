@@ -58,6 +58,11 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
+    virtual bool fusable() const
+        { return true; }
+    virtual bool processOne(PointView& view, PointId idx);
 
 private:
     virtual void processOptions(const Options& options);
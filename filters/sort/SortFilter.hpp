@@ -52,6 +52,15 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool parallelizable() const
+        { return true; }
+    virtual bool usedDimensions(StringList& dims) const
+    {
+        dims.push_back(m_dimName);
+        return true;
+    }
+    virtual bool pointwise() const
+        { return true; }
 
 private:
     // Dimension on which to sort.
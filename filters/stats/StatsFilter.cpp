@@ -80,17 +80,22 @@ void Summary::extractMetadata(MetadataNode &m) const
 
 using namespace stats;
 
-void StatsFilter::filter(PointView& view)
+bool StatsFilter::processOne(PointView& view, PointId idx)
 {
-    for (PointId idx = 0; idx < view.size(); ++idx)
+    for (auto p = m_stats.begin(); p != m_stats.end(); ++p)
     {
-        for (auto p = m_stats.begin(); p != m_stats.end(); ++p)
-        {
-            Dimension::Id::Enum d = p->first;
-            Summary& c = p->second;
-            c.insert(view.getFieldAs<double>(d, idx));
-        }
+        Dimension::Id::Enum d = p->first;
+        Summary& c = p->second;
+        c.insert(view.getFieldAs<double>(d, idx));
     }
+    return true;
+}
+
+
+void StatsFilter::filter(PointView& view)
+{
+    for (PointId idx = 0; idx < view.size(); ++idx)
+        processOne(view, idx);
 }
 
 
@@ -108,6 +113,16 @@ void StatsFilter::processOptions(const Options& options)
 }
 
 
+// Statistics are computed for every dimension unless some are listed.
+bool StatsFilter::usedDimensions(StringList& dims) const
+{
+    if (m_dimNames.empty())
+        return false;
+    dims.insert(dims.end(), m_dimNames.begin(), m_dimNames.end());
+    return true;
+}
+
+
 void StatsFilter::prepared(PointTableRef table)
 {
     PointLayoutPtr layout(table.layout());
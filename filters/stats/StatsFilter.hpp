@@ -117,6 +117,12 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
+    virtual bool usedDimensions(StringList& dims) const;
+    virtual bool fusable() const
+        { return true; }
+    virtual bool processOne(PointView& view, PointId idx);
 
     const stats::Summary& getStats(Dimension::Id::Enum d) const;
     void reset();
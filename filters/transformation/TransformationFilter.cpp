@@ -90,23 +90,60 @@ void TransformationFilter::processOptions(const Options& options)
 }
 
 
-void TransformationFilter::filter(PointView& view)
+bool TransformationFilter::processOne(PointView& view, PointId idx)
 {
-    for (PointId idx = 0; idx < view.size(); ++idx)
-    {
-        double x = view.getFieldAs<double>(Dimension::Id::X, idx);
-        double y = view.getFieldAs<double>(Dimension::Id::Y, idx);
-        double z = view.getFieldAs<double>(Dimension::Id::Z, idx);
+    double x = view.getFieldAs<double>(Dimension::Id::X, idx);
+    double y = view.getFieldAs<double>(Dimension::Id::Y, idx);
+    double z = view.getFieldAs<double>(Dimension::Id::Z, idx);
 
-        view.setField(Dimension::Id::X, idx,
-            x * m_matrix[0] + y * m_matrix[1] + z * m_matrix[2] + m_matrix[3]);
+    view.setField(Dimension::Id::X, idx,
+        x * m_matrix[0] + y * m_matrix[1] + z * m_matrix[2] + m_matrix[3]);
 
-        view.setField(Dimension::Id::Y, idx,
-            x * m_matrix[4] + y * m_matrix[5] + z * m_matrix[6] + m_matrix[7]);
+    view.setField(Dimension::Id::Y, idx,
+        x * m_matrix[4] + y * m_matrix[5] + z * m_matrix[6] + m_matrix[7]);
+
+    view.setField(Dimension::Id::Z, idx,
+        x * m_matrix[8] + y * m_matrix[9] + z * m_matrix[10] + m_matrix[11]);
+    return true;
+}
 
-        view.setField(Dimension::Id::Z, idx,
-            x * m_matrix[8] + y * m_matrix[9] + z * m_matrix[10] + m_matrix[11]);
+
+void TransformationFilter::filter(PointView& view)
+{
+    using namespace Dimension;
+
+    PointId idx = 0;
+
+    // When the points are stored in columns of doubles, transform them
+    // in place a run at a time.
+    if (view.dimType(Id::X) == Type::Double &&
+        view.dimType(Id::Y) == Type::Double &&
+        view.dimType(Id::Z) == Type::Double)
+    {
+        point_count_t count;
+        while (double *x = view.column<double>(Id::X, idx, count))
+        {
+            double *y = view.column<double>(Id::Y, idx, count);
+            double *z = view.column<double>(Id::Z, idx, count);
+            for (point_count_t i = 0; i < count; ++i)
+            {
+                double xv = x[i];
+                double yv = y[i];
+                double zv = z[i];
+
+                x[i] = xv * m_matrix[0] + yv * m_matrix[1] +
+                    zv * m_matrix[2] + m_matrix[3];
+                y[i] = xv * m_matrix[4] + yv * m_matrix[5] +
+                    zv * m_matrix[6] + m_matrix[7];
+                z[i] = xv * m_matrix[8] + yv * m_matrix[9] +
+                    zv * m_matrix[10] + m_matrix[11];
+            }
+            idx += count;
+        }
     }
+
+    for (; idx < view.size(); ++idx)
+        processOne(view, idx);
 }
 
 } // namespace pdal
@@ -63,6 +63,18 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
+    virtual bool parallelizable() const
+        { return true; }
+    virtual bool usedDimensions(StringList& dims) const
+    {
+        dims.insert(dims.end(), { "X", "Y", "Z" });
+        return true;
+    }
+    virtual bool fusable() const
+        { return true; }
+    virtual bool processOne(PointView& view, PointId idx);
 
 private:
     TransformationFilter& operator=(const TransformationFilter&); // not implemented
@@ -62,6 +62,17 @@ public:
     // for xml serializion of pipelines
     virtual boost::property_tree::ptree serializePipeline() const;
 
+    // Whether the filter processes each point on its own with
+    // processOne().  Runs of such filters are run together in a single
+    // pass over the points.  Views are processed on separate threads when
+    // every filter of the run is parallelizable().
+    virtual bool fusable() const
+        { return false; }
+    // Process the point at 'idx' in 'view'.  Return false if the point
+    // should be removed from the view.
+    virtual bool processOne(PointView& /*view*/, PointId /*idx*/)
+        { return true; }
+
 private:
     virtual PointViewSet run(PointViewPtr view)
     {
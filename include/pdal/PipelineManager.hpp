@@ -49,15 +49,16 @@ class PDAL_DLL PipelineManager
 {
 public:
     PipelineManager() : m_tablePtr(new PointTable()), m_table(*m_tablePtr),
-            m_progressFd(-1)
+            m_progressFd(-1), m_threads(1)
         {}
     PipelineManager(int progressFd) : m_tablePtr(new PointTable()),
-            m_table(*m_tablePtr), m_progressFd(progressFd)
+            m_table(*m_tablePtr), m_progressFd(progressFd), m_threads(1)
         {}
-    PipelineManager(PointTableRef table) : m_table(table), m_progressFd(-1)
+    PipelineManager(PointTableRef table) : m_table(table), m_progressFd(-1),
+            m_threads(1)
         {}
     PipelineManager(PointTableRef table, int progressFd) : m_table(table),
-            m_progressFd(progressFd)
+            m_progressFd(progressFd), m_threads(1)
         {}
 
     // Use these to manually add stages into the pipeline manager.
@@ -73,8 +74,18 @@ public:
     Stage* getStage() const
         { return m_stages.empty() ? NULL : m_stages.back().get(); }
 
+    // Set the maximum number of threads used to run any one stage of
+    // the pipeline.
+    void setThreads(size_t threads)
+        { m_threads = threads; }
+    size_t threads() const
+        { return m_threads; }
+
     void prepare() const;
     point_count_t execute();
+    // Run the pipeline a chunk at a time using the provided table rather
+    // than the pipeline manager's point table.
+    void executeStream(StreamPointTable& table);
 
     // Get the resulting point views.
     const PointViewSet& views() const
@@ -85,6 +96,8 @@ public:
         { return m_table; }
 
     MetadataNode getMetadata() const;
+    // Write a table of the time spent and points handled by each stage.
+    void writeProfile(std::ostream& out) const;
 
 private:
     StageFactory m_factory;
@@ -96,6 +109,7 @@ private:
     typedef std::vector<std::unique_ptr<Stage> > StagePtrList;
     StagePtrList m_stages;
     int m_progressFd;
+    size_t m_threads;
 
     PipelineManager& operator=(const PipelineManager&); // not implemented
     PipelineManager(const PipelineManager&); // not implemented
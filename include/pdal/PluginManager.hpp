@@ -51,6 +51,7 @@ namespace pdal
 {
 
 class DynamicLibrary;
+class PluginManagerTester;
 
 /*
  * I think PluginManager can eventually be a private header, only accessible
@@ -58,6 +59,8 @@ class DynamicLibrary;
  */
 class PDAL_DLL PluginManager
 {
+    friend class PluginManagerTester;
+
     typedef std::shared_ptr<DynamicLibrary> DynLibPtr;
     typedef std::map<std::string, std::shared_ptr<DynamicLibrary>>
         DynamicLibraryMap;
@@ -82,13 +85,21 @@ public:
         const PF_RegisterParams* params);
     const RegistrationMap& getRegistrationMap();
 
+    // Name of the file that records which plugin library provides each
+    // stage and kernel, so that only the library for a requested driver
+    // is loaded.  Set PDAL_PLUGIN_MANIFEST to override the default.
+    static std::string manifestFilename();
+
 private:
     PluginManager();
     ~PluginManager();
 
     // These functions return true if successful.
     bool shutdown();
-    bool guessLoadByPath(const std::string & driverName);
+    bool loadByManifest(const std::string & driverName);
+    bool readManifest(const std::string & filename);
+    void buildManifest();
+    void writeManifest(const std::string & filename);
     bool loadByPath(const std::string & path, PF_PluginType type);
 
     DynamicLibrary *loadLibrary(const std::string& path,
@@ -99,6 +110,11 @@ private:
     ExitFuncVec m_exitFuncVec;
     RegistrationMap m_tempExactMatchMap;
     RegistrationMap m_exactMatchMap;
+    // Drivers registered by each plugin library that has been loaded.
+    std::map<std::string, std::vector<std::string>> m_libraryDrivers;
+    // Plugin library that provides each driver, from the manifest.
+    std::map<std::string, std::string> m_manifest;
+    bool m_manifestReady;
 
     // Disable copy/assignment.
     PluginManager(const PluginManager&);
@@ -0,0 +1,153 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_internal.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace pdal
+{
+
+// The map from the positions of points in a view to their IDs in the
+// point table.  The index takes one of three forms:
+//
+// - A range.  Most views, such as those filled by readers, refer to a
+//   contiguous range of table IDs, so only the first ID and the count
+//   are stored.
+// - A list of IDs, used once points are reordered or a point that doesn't
+//   follow the range is added.  The list is shared between copies of an
+//   index and copied when one of them is changed.
+// - A selection, which is a bitmask over the positions of a base range or
+//   list.  Predicate filters use selections (see PointView::select()) so
+//   that chained filters don't each build a full list of IDs.  A point of
+//   a selection is found by counting bits from the nearest entry of a
+//   rank directory, so lookups don't change the index and may be made
+//   from several threads at once.
+//
+// Any change to a selection other than appending points after a range
+// turns it into a list.
+class PDAL_DLL PointIndex
+{
+public:
+    PointIndex() : m_mode(Range), m_start(0), m_count(0)
+        {}
+
+    point_count_t size() const
+        { return m_mode == List ? (point_count_t)m_ids->size() : m_count; }
+
+    // Whether the index is a range of IDs.  If so, the ID of the point
+    // at position 'i' is start() + i.
+    bool contiguous() const
+        { return m_mode == Range; }
+    bool selection() const
+        { return m_mode == Selection; }
+    PointId start() const
+        { return m_start; }
+
+    PointId operator[](PointId i) const
+    {
+        if (m_mode == Range)
+            return m_start + i;
+        if (m_mode == List)
+            return (*m_ids)[i];
+        return baseId(select(i));
+    }
+
+    void set(PointId i, PointId id)
+    {
+        if (m_mode == Range && id == m_start + i)
+            return;
+        expand();
+        (*m_ids)[i] = id;
+    }
+
+    void push_back(PointId id)
+    {
+        if (m_mode == Range)
+        {
+            if (m_count == 0)
+                m_start = id;
+            if (id == m_start + m_count)
+            {
+                m_count++;
+                return;
+            }
+        }
+        expand();
+        m_ids->push_back(id);
+    }
+
+    void push_back(PointId start, point_count_t count);
+    void insert(point_count_t pos, const PointIndex& src, PointId srcPos,
+        point_count_t count);
+    PointIndex select(const std::vector<uint64_t>& keep,
+        point_count_t count) const;
+
+private:
+    enum Mode
+    {
+        Range,
+        List,
+        Selection
+    };
+
+    // The number of mask words between entries of the rank directory.
+    static const size_t m_rankWords = 8;
+
+    Mode m_mode;
+    // First ID of a range, or of the base range of a selection.
+    PointId m_start;
+    // Number of points in a range or selection.
+    point_count_t m_count;
+    // IDs of a list, or the base list of a selection.  NULL if the index
+    // is a range or a selection of a range.
+    std::shared_ptr<std::vector<PointId>> m_ids;
+    // Bits for the selected base positions of a selection, and the number
+    // of bits set before each group of m_rankWords words.
+    std::vector<uint64_t> m_mask;
+    std::vector<point_count_t> m_ranks;
+
+    PointId baseId(PointId basePos) const
+        { return m_ids ? (*m_ids)[basePos] : m_start + basePos; }
+    PointId select(PointId i) const;
+    PointId nextSelected(PointId basePos) const;
+    void getIds(PointId pos, point_count_t count, PointId *ids) const;
+    void buildRanks();
+    void expand();
+};
+
+} // namespace pdal
@@ -95,6 +95,11 @@ public:
 
     const Dimension::Detail *dimDetail(Dimension::Id::Enum id) const;
 
+    // @return whether the layouts have the same dimensions with the same
+    //         types at the same offsets, so that packed points are
+    //         interchangeable.
+    bool equal(const PointLayout& other) const;
+
 private:
     virtual bool update(Dimension::Detail dd, const std::string& name);
 
@@ -34,11 +34,18 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #include "pdal/Dimension.hpp"
+#include "pdal/PointIndex.hpp"
 #include "pdal/PointLayout.hpp"
 #include "pdal/Metadata.hpp"
 
@@ -66,9 +73,21 @@ public:
     void setSpatialRef(const SpatialReference& sref);
     MetadataNode privateMetadata(const std::string& name);
 
+    // Lock held by stages while they're readied and finished so that
+    // pipeline branches run in separate threads don't modify the table's
+    // metadata at the same time.
+    std::mutex& stageMutex()
+        { return m_stageMutex; }
+
+    // Number of bytes of point storage held by the table.
+    virtual std::size_t allocatedBytes() const
+        { return 0; }
+
 private:
     // Point data operations.
     virtual PointId addPoint() = 0;
+    // Add 'count' points, appending their IDs to 'index'.
+    virtual void addPoints(point_count_t count, PointIndex& index);
     virtual char *getPoint(PointId idx) = 0;
     virtual void setField(const Dimension::Detail *d, PointId idx,
         const void *value) = 0;
@@ -77,6 +96,9 @@ private:
 
 protected:
     MetadataPtr m_metadata;
+
+private:
+    std::mutex m_stageMutex;
 };
 typedef BasePointTable& PointTableRef;
 typedef BasePointTable const & ConstPointTableRef;
@@ -87,33 +109,252 @@ typedef BasePointTable const & ConstPointTableRef;
 class PDAL_DLL PointTable : public BasePointTable
 {
 private:
-    // Point storage.
-    std::vector<char *> m_blocks;
+    // The number of block pointers in each level of the block directory.
+    static const point_count_t m_dirSize = 1024;
+
+    // Point storage.  Blocks are found through a two-level directory
+    // whose entries never move once set, so points can be read while
+    // other threads are adding points.
+    std::vector<char **> m_blocks;
     point_count_t m_numPts;
     std::unique_ptr<PointLayout> m_layout;
+    std::mutex m_mutex;
+    // The number of points in each memory block, as a power of two.
+    point_count_t m_blockPtCnt;
+    int m_blockShift;
+    bool m_zeroFill;
+    bool m_hugePages;
+    std::atomic<std::size_t> m_allocatedBytes;
 
 public:
-    PointTable() : m_numPts(0), m_layout(new PointLayout())
-        {}
+    /// \param blockPtCnt  Number of points in each memory block.  Must be
+    ///   a power of two no smaller than 1024.
+    PointTable(point_count_t blockPtCnt = 65536);
     virtual ~PointTable();
 
     virtual PointLayoutPtr layout() const
         { return m_layout.get(); }
 
-private:
+    point_count_t blockPtCnt() const
+        { return m_blockPtCnt; }
+    virtual std::size_t allocatedBytes() const
+        { return m_allocatedBytes; }
+
+    // Whether memory blocks reused from the block pool are cleared before
+    // use.  Newly allocated blocks are always zero-filled.  Turn this off
+    // when every field of every point will be written anyway.
+    void setZeroFill(bool zeroFill)
+        { m_zeroFill = zeroFill; }
+    // Whether memory blocks should be backed by transparent huge pages,
+    // where the system supports them.
+    void setHugePages(bool hugePages)
+        { m_hugePages = hugePages; }
+
+    // Set the maximum number of bytes of freed memory blocks kept for reuse
+    // by point tables in this process.
+    static void setPoolLimit(std::size_t bytes);
+
+protected:
+    point_count_t numPoints() const
+        { return m_numPts; }
+
+    // Get the memory block that holds the point 'idx'.
+    char *getBlock(PointId idx)
+    {
+        point_count_t block = idx >> m_blockShift;
+        return m_blocks[block / m_dirSize][block % m_dirSize];
+    }
+
+    // Get the position of the point 'idx' in its memory block.
+    point_count_t blockOffset(PointId idx) const
+        { return idx & (m_blockPtCnt - 1); }
+
+    std::size_t pointsToBytes(point_count_t numPts)
+        { return m_layout->pointSize() * numPts; }
+
+    // Allocate a zero-filled memory block of 'size' bytes.  Called with
+    // the table locked.
+    virtual char *allocateBlock(std::size_t size);
+    virtual void freeBlock(char *block, std::size_t size);
+    // Free all blocks.  Subclasses that allocate their own blocks must call
+    // this from their destructors, since freeBlock() can't be dispatched
+    // to them once they've been destroyed.
+    void clearBlocks();
+
     // Point data operations.
     virtual PointId addPoint();
+    virtual void addPoints(point_count_t count, PointIndex& index);
     virtual char *getPoint(PointId idx);
+
+private:
     virtual void setField(const Dimension::Detail *d, PointId idx,
         const void *value);
     virtual void getField(const Dimension::Detail *d, PointId idx,
         void *value);
 
-    // The number of points in each memory block.
-    static const point_count_t m_blockPtCnt = 65536;
-
     char *getDimension(const Dimension::Detail *d, PointId idx)
         { return getPoint(idx) + d->offset(); }
+    void allocateBlocks(point_count_t numPts);
+};
+
+
+// A point table that stores the values of each dimension together rather
+// than storing the values of each point together.  Each memory block holds
+// a contiguous column of blockPtCnt() values for every dimension, so
+// filters that use only a few dimensions of a wide layout touch less
+// memory, and loops over a single dimension can work on the columns
+// directly with column().  There is no packed point data, so getPoint()
+// returns NULL.
+class PDAL_DLL ColumnPointTable : public PointTable
+{
+public:
+    ColumnPointTable(point_count_t blockPtCnt = 65536) :
+            PointTable(blockPtCnt)
+        {}
+
+    /// Get the values of a dimension for a run of points stored
+    /// contiguously, starting with the point 'idx'.  A run ends at the end
+    /// of a memory block or the last point in the table.
+    /// \param[in] dim  Dimension whose values should be returned.
+    /// \param[in] idx  Table index of the first point of the run.
+    /// \param[out] count  Number of points in the run.
+    /// \return  Pointer to the value for the point 'idx'.
+    template<typename T>
+    T *column(Dimension::Id::Enum dim, PointId idx, point_count_t& count)
+    {
+        const Dimension::Detail *d = layout()->dimDetail(dim);
+        if (d->size() != sizeof(T))
+        {
+            std::ostringstream oss;
+            oss << "Can't access column for dimension '" <<
+                Dimension::name(dim) << "' as a type of size " <<
+                sizeof(T) << ".";
+            throw pdal_error(oss.str());
+        }
+        if (idx >= numPoints())
+        {
+            count = 0;
+            return NULL;
+        }
+        point_count_t blockEnd = idx - blockOffset(idx) + blockPtCnt();
+        count = (std::min)(blockEnd, numPoints()) - idx;
+        return (T *)getDimension(d, idx);
+    }
+
+private:
+    virtual char *getPoint(PointId /*idx*/)
+        { return NULL; }
+    virtual void setField(const Dimension::Detail *d, PointId idx,
+        const void *value);
+    virtual void getField(const Dimension::Detail *d, PointId idx,
+        void *value);
+
+    // Columns are laid out in the block in the same order as dimensions
+    // are laid out in a packed point.
+    char *getDimension(const Dimension::Detail *d, PointId idx)
+    {
+        return getBlock(idx) + (std::size_t)d->offset() * blockPtCnt() +
+            blockOffset(idx) * d->size();
+    }
+};
+
+
+// A point table whose blocks are stored in a memory-mapped scratch file
+// rather than in allocated memory, so that point sets larger than the
+// available RAM can be processed.  Once more than 'budget' bytes of blocks
+// are resident, the blocks that became resident first are flushed to the
+// file and their pages are released.  Released blocks are paged back in
+// from the file as they're accessed, and count against the budget again.
+// The scratch file is unlinked once it's created, so it goes away when the
+// table is destroyed, even if the process is killed.  Not available on
+// Windows.
+class PDAL_DLL MappedPointTable : public PointTable
+{
+public:
+    MappedPointTable(const std::string& scratchDir = "",
+        std::size_t budget = 1024 * 1024 * 1024);
+    virtual ~MappedPointTable();
+
+    std::string scratchDir() const
+        { return m_scratchDir; }
+    std::size_t budget() const
+        { return m_budget; }
+    // Number of bytes of blocks counted as resident.
+    std::size_t residentSize();
+
+private:
+    std::string m_scratchDir;
+    std::size_t m_budget;
+    int m_fd;
+    std::size_t m_fileSize;
+    // Mapped size of each block.
+    std::size_t m_blockSize;
+    // Lock for the resident and released blocks.  Blocks are flushed and
+    // released after it's unlocked.
+    std::mutex m_residentMutex;
+    // Resident blocks and their numbers, in the order they became
+    // resident, and their total size.
+    std::queue<std::pair<char *, point_count_t>> m_resident;
+    std::size_t m_residentSize;
+    // Whether each block has been released, and the blocks to be flushed
+    // and released.
+    std::unique_ptr<std::atomic<bool>[]> m_released;
+    std::vector<char *> m_pending;
+    std::atomic<bool> m_hasPending;
+
+    virtual char *allocateBlock(std::size_t size);
+    virtual void freeBlock(char *block, std::size_t size);
+    virtual PointId addPoint();
+    virtual void addPoints(point_count_t count, PointIndex& index);
+    virtual char *getPoint(PointId idx);
+    std::size_t mappedSize(std::size_t size) const;
+    void openScratch();
+    void addResident(char *block, point_count_t blockNum);
+    void reload(PointId idx);
+    void releasePending();
+};
+
+
+// A point table with a fixed capacity whose storage is reused.  It backs
+// streaming execution (see Stage::execute(StreamPointTable&)), where points
+// flow through a pipeline a chunk at a time so that memory use doesn't
+// depend on the size of the input.
+class PDAL_DLL StreamPointTable : public BasePointTable
+{
+private:
+    // Point storage.
+    std::vector<char> m_buf;
+    point_count_t m_capacity;
+    point_count_t m_numPts;
+    std::unique_ptr<PointLayout> m_layout;
+
+public:
+    StreamPointTable(point_count_t capacity = 65536) : m_capacity(capacity),
+        m_numPts(0), m_layout(new PointLayout())
+        {}
+
+    virtual PointLayoutPtr layout() const
+        { return m_layout.get(); }
+
+    // The maximum number of points that the table can hold at once.
+    point_count_t capacity() const
+        { return m_capacity; }
+
+    // Discard all points so that the storage can be reused for the next
+    // chunk.  Any views that refer to the table become invalid.
+    void reset()
+        { m_numPts = 0; }
+
+private:
+    // Point data operations.
+    virtual PointId addPoint();
+    virtual void addPoints(point_count_t count, PointIndex& index);
+    virtual char *getPoint(PointId idx)
+        { return m_buf.data() + pointsToBytes(idx); }
+    virtual void setField(const Dimension::Detail *d, PointId idx,
+        const void *value);
+    virtual void getField(const Dimension::Detail *d, PointId idx,
+        void *value);
 
     std::size_t pointsToBytes(point_count_t numPts)
         { return m_layout->pointSize() * numPts; }
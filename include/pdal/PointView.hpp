@@ -36,14 +36,15 @@
 
 #include <pdal/util/Bounds.hpp>
 #include <pdal/pdal_internal.hpp>
+#include <pdal/PointIndex.hpp>
 #include <pdal/PointLayout.hpp>
 #include <pdal/PointTable.hpp>
 
+#include <atomic>
 #include <memory>
 #include <queue>
 #include <set>
 #include <vector>
-#include <deque>
 
 #ifdef PDAL_COMPILER_MSVC
 #  pragma warning(disable: 4244)  // conversion from 'type1' to 'type2', possible loss of data
@@ -72,7 +73,8 @@ public:
     PointView(PointTableRef pointTable) : m_pointTable(pointTable),
         m_size(0), m_id(0)
     {
-        static int lastId = 0;
+        // Views may be created by stages running in separate threads.
+        static std::atomic<int> lastId(0);
         m_id = ++lastId;
     }
 
@@ -93,21 +95,66 @@ public:
 
     inline void appendPoint(const PointView& buffer, PointId id);
     void append(const PointView& buf)
+        { append(buf, 0, buf.size()); }
+
+    /// Append a range of the points of a view that shares this view's
+    /// point table.
+    /// \param buf  View containing points to append.
+    /// \param start  Index in 'buf' of the first point to append.
+    /// \param count  Number of points to append.
+    void append(const PointView& buf, PointId start, point_count_t count)
     {
         // We use size() instead of the index end because temp points
         // might have been placed at the end of the buffer.
-        auto thisEnd = m_index.begin() + size();
-        auto bufEnd = buf.m_index.begin() + buf.size();
-        m_index.insert(thisEnd, buf.m_index.begin(), bufEnd);
-        m_size += buf.size();
+        m_index.insert(size(), buf.m_index, start, count);
+        m_size += count;
         clearTemps();
     }
 
+    /// Add points to the end of the view in a single operation.  Fields
+    /// of the new points are zero.
+    /// \param count  Number of points to add.
+    /// \return  Index in the view of the first new point.
+    PointId addPoints(point_count_t count)
+    {
+        assert(m_temps.empty());
+        PointId first = size();
+        m_pointTable.addPoints(count, m_index);
+        m_size += count;
+        return first;
+    }
+
+    void copyPoints(const PointView& src, PointId start, point_count_t count);
+
     /// Return a new point view with the same point table as this
     /// point buffer.
     PointViewPtr makeNew() const
         { return PointViewPtr(new PointView(m_pointTable)); }
 
+    /// Return a new point view with the points of this view for which
+    /// a predicate is true.  The points of the new view are recorded as a
+    /// selection of this view's index rather than a new list of IDs.
+    /// \param pred  Function called with the index of each point in this
+    ///   view, returning true if the point should be kept.
+    /// \return  View of the selected points, in their order in this view.
+    template<typename PREDICATE>
+    PointViewPtr select(PREDICATE pred) const
+    {
+        std::vector<uint64_t> keep((size() + 63) / 64);
+        point_count_t count = 0;
+        for (PointId i = 0; i < size(); ++i)
+            if (pred(i))
+            {
+                keep[i >> 6] |= (uint64_t)1 << (i & 63);
+                count++;
+            }
+
+        PointViewPtr view = makeNew();
+        view->m_index = m_index.select(keep, count);
+        view->m_size = count;
+        return view;
+    }
+
     template<class T>
     T getFieldAs(Dimension::Id::Enum dim, PointId pointIndex) const;
 
@@ -235,6 +282,30 @@ public:
     }
 
 
+    /// Get the values of a dimension for a run of points of the view that
+    /// are stored together, starting with the point 'idx'.  Values are
+    /// only stored together when the view's points are stored in order in
+    /// a ColumnPointTable.
+    /// \param[in] dim  Dimension whose values should be returned.
+    /// \param[in] idx  Index in the view of the first point of the run.
+    /// \param[out] count  Number of points in the run.
+    /// \return  Pointer to the value for the point 'idx', or NULL if the
+    ///   values of the view's points aren't stored together.
+    template<typename T>
+    T *column(Dimension::Id::Enum dim, PointId idx, point_count_t& count)
+    {
+        ColumnPointTable *table =
+            dynamic_cast<ColumnPointTable *>(&m_pointTable);
+        if (!table || !m_index.contiguous() || idx >= size())
+        {
+            count = 0;
+            return NULL;
+        }
+        T *vals = table->column<T>(dim, m_index.start() + idx, count);
+        count = (std::min)(count, size() - idx);
+        return vals;
+    }
+
     /// Provides access to the memory storing the point data.  Though this
     /// function is public, other access methods are safer and preferred.
     char *getPoint(PointId id)
@@ -251,7 +322,7 @@ public:
 
 protected:
     PointTableRef m_pointTable;
-    std::deque<PointId> m_index;
+    PointIndex m_index;
     // The index might be larger than the size to support temporary point
     // references.
     point_count_t m_size;
@@ -555,7 +626,7 @@ inline PointId PointView::getTemp(PointId id)
     {
         newid = m_temps.front();
         m_temps.pop();
-        m_index[newid] = m_index[id];
+        m_index.set(newid, m_index[id]);
     }
     else
     {
@@ -44,6 +44,7 @@ class Reader;
 
 class PDAL_DLL Reader : public Stage
 {
+    friend class Stage;
 public:
     typedef std::function<void(PointView&, PointId)> PointReadFunc;
 
@@ -69,6 +70,10 @@ private:
         return viewSet;
     }
     virtual void readerProcessOptions(const Options& options);
+    // Read up to 'num' points into 'view' and return the number read.
+    // Readers that sample every Nth point count only the points sampled.
+    // Points read outside the bounds used by later stages may be dropped
+    // rather than added to the view.
     virtual point_count_t read(PointViewPtr /*view*/, point_count_t /*num*/)
         { return 0; }
     virtual boost::property_tree::ptree serializePipeline() const;
@@ -49,9 +49,12 @@
 
 #include <boost/property_tree/ptree.hpp>
 
+#include <set>
+
 namespace pdal
 {
 
+class Filter;
 class Iterator;
 class StageSequentialIterator;
 class StageRandomIterator;
@@ -59,6 +62,29 @@ class StageBlockIterator;
 class StageRunner;
 class StageWrapper;
 
+// Time spent and points handled by a stage when a pipeline is prepared
+// and run.  Times are in seconds.  CPU time is that of the whole process
+// while the stage ran.  When filters are fused, the time of the single
+// pass is recorded by the last filter of the chain.
+struct StageProfile
+{
+    StageProfile() : m_prepareTime(0), m_wallTime(0), m_cpuTime(0),
+        m_pointsIn(0), m_pointsOut(0), m_viewsIn(0), m_viewsOut(0),
+        m_bytesAllocated(0), m_fused(false)
+    {}
+
+    double m_prepareTime;
+    double m_wallTime;
+    double m_cpuTime;
+    point_count_t m_pointsIn;
+    point_count_t m_pointsOut;
+    point_count_t m_viewsIn;
+    point_count_t m_viewsOut;
+    // Bytes of point storage added to the table while the stage ran.
+    uint64_t m_bytesAllocated;
+    bool m_fused;
+};
+
 class PDAL_DLL Stage
 {
     friend class StageWrapper;
@@ -82,6 +108,36 @@ public:
     }
     void prepare(PointTableRef table);
     PointViewSet execute(PointTableRef table);
+    void execute(StreamPointTable& table);
+
+    // Whether this stage can process its points a chunk at a time.
+    virtual bool streamable() const
+        { return false; }
+    // Whether this stage and all stages that feed it can be run in
+    // streaming mode.
+    bool pipelineStreamable() const;
+    // Whether this stage can be run on separate views at the same time.
+    virtual bool parallelizable() const
+        { return false; }
+    void setThreads(size_t threads);
+    size_t threads() const
+        { return m_threads; }
+    // Add the names of the dimensions this stage reads to 'dims'.  Return
+    // false if the stage may read any dimension, as does a writer that
+    // writes every dimension of the table.  Readers are told which
+    // dimensions are read after them so they can skip the others.
+    virtual bool usedDimensions(StringList& /*dims*/) const
+        { return false; }
+    // Set 'bounds' to the bounds outside of which this stage drops all
+    // points and return true.  Return false if there are no such bounds.
+    virtual bool cropBounds(BOX3D& /*bounds*/) const
+        { return false; }
+    // Whether points can be removed from the input of this stage without
+    // changing the output for the other points, as for stages that test or
+    // reorder points without changing X, Y or Z.  Bounds given by later
+    // stages are only passed to the inputs of such stages.
+    virtual bool pointwise() const
+        { return false; }
 
     void setSpatialReference(SpatialReference const&);
     const SpatialReference& getSpatialReference() const;
@@ -127,6 +183,8 @@ public:
         { return NULL; }
     inline MetadataNode getMetadata() const
         { return m_metadata; }
+    const StageProfile& profile() const
+        { return m_profile; }
 
     /// Sets the UserCallback to manage progress/cancel operations
     void setUserCallback(UserCallback* userCallback)
@@ -139,6 +197,15 @@ protected:
     int m_progressFd;
 
     void setSpatialReference(MetadataNode& m, SpatialReference const&);
+    // Whether a stage that follows this one reads a dimension.
+    bool dimensionUsed(Dimension::Id::Enum id) const
+        { return dimensionUsed(Dimension::name(id)); }
+    bool dimensionUsed(const std::string& name) const
+        { return m_allDims || m_usedDims.count(name); }
+    // Bounds outside of which no later stage uses points.  Readers can
+    // skip points outside the bounds.
+    const BOX3D& boundsHint() const
+        { return m_boundsHint; }
 
 private:
     bool m_debug;
@@ -146,11 +213,24 @@ private:
     std::vector<Stage *> m_inputs;
     LogPtr m_log;
     SpatialReference m_spatialReference;
+    size_t m_threads;
+    bool m_allDims;
+    std::set<std::string> m_usedDims;
+    BOX3D m_boundsHint;
+    StageProfile m_profile;
 
     Stage& operator=(const Stage&); // not implemented
     Stage(const Stage&); // not implemented
     void Construct();
     void l_processOptions(const Options& options);
+    void processStageOptions();
+    void prepareStage(PointTableRef table);
+    void clearHints();
+    void pushUsedDimensions(bool all, const std::set<std::string>& dims);
+    void pushBoundsHint(BOX3D bounds);
+    void addProfile(double wallTime, double cpuTime,
+        const PointViewSet& in, const PointViewSet& out, std::size_t bytes);
+    void profileMetadata();
     virtual void processOptions(const Options& /*options*/)
         {}
     virtual void readerProcessOptions(const Options& /*options*/)
@@ -159,6 +239,12 @@ private:
         {}
     void l_initialize(PointTableRef table);
     void l_done(PointTableRef table);
+    PointViewSet executeStage(PointTableRef table);
+    PointViewSet executeInputs(PointTableRef table);
+    std::vector<Filter *> fusedFilters();
+    PointViewSet executeFused(PointTableRef table,
+        const std::vector<Filter *>& chain);
+    std::vector<Stage *> streamStages();
     virtual QuickInfo inspect()
         { return QuickInfo(); }
     virtual void initialize()
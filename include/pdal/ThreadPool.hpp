@@ -0,0 +1,114 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace pdal
+{
+
+// Fixed-size pool of worker threads that run queued tasks in FIFO order.
+// Tasks should not throw; callers that need results or errors should
+// wrap their work in a std::packaged_task.
+class ThreadPool
+{
+public:
+    ThreadPool(size_t numThreads) : m_stop(false)
+    {
+        if (numThreads == 0)
+            numThreads = 1;
+        for (size_t i = 0; i < numThreads; ++i)
+            m_workers.push_back(std::thread([this](){ work(); }));
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        for (auto& t : m_workers)
+            t.join();
+    }
+
+    size_t size() const
+        { return m_workers.size(); }
+
+    void add(std::function<void()> task)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_tasks.push(task);
+        }
+        m_cv.notify_one();
+    }
+
+private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop;
+
+    // Run tasks until the pool is stopped and the queue has drained.
+    void work()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this](){ return m_stop || !m_tasks.empty(); });
+                if (m_tasks.empty())
+                    return;
+                task = m_tasks.front();
+                m_tasks.pop();
+            }
+            task();
+        }
+    }
+
+    ThreadPool& operator=(const ThreadPool&); // not implemented
+    ThreadPool(const ThreadPool&); // not implemented
+};
+
+} // namespace pdal
+
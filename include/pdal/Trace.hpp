@@ -0,0 +1,88 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_internal.hpp>
+
+#include <chrono>
+#include <ostream>
+#include <string>
+
+namespace pdal
+{
+
+// Records a timeline of the work done by each thread while pipelines are
+// prepared and run.  Recording is off until start() is called, and then
+// spans are added by TraceScope objects placed around stage runs, block
+// reads and writes, compression and calls into GDAL and GEOS.  The trace
+// is written in the trace event JSON format, which can be loaded into
+// chrome://tracing and other trace viewers.
+class PDAL_DLL Trace
+{
+public:
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    // Discard any recorded events and start recording.  Times are relative
+    // to the call to start() and the calling thread is named "main".
+    static void start();
+    static void stop();
+    static bool enabled();
+
+    static void record(const std::string& category, const std::string& name,
+        TimePoint start, TimePoint end);
+    static void write(std::ostream& out);
+    static void write(const std::string& filename);
+};
+
+
+// Records a span of the current thread from construction to destruction
+// when tracing is enabled.  Costs little more than a flag test otherwise.
+class PDAL_DLL TraceScope
+{
+public:
+    TraceScope(const char *category, const std::string& name);
+    ~TraceScope();
+
+private:
+    bool m_active;
+    const char *m_category;
+    std::string m_name;
+    Trace::TimePoint m_start;
+
+    TraceScope(const TraceScope&); // not implemented
+    TraceScope& operator=(const TraceScope&); // not implemented
+};
+
+} // namespace pdal
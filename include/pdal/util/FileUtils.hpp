@@ -81,6 +81,12 @@ public:
     static bool fileExists(const std::string& filename);
     static uintmax_t fileSize(const std::string& filename);
 
+    // tell the system that a range of a file won't be read again soon, so
+    // its pages needn't be kept in the page cache.  Dirty pages are
+    // written back first.  Does nothing where unsupported.
+    static void adviseDontNeed(const std::string& filename,
+        uintmax_t offset, uintmax_t length);
+
     // reads a file into a text string for you
     static std::string readFileIntoString(const std::string& filename);
 
@@ -0,0 +1,81 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_export.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace pdal
+{
+
+// A file mapped read-only into memory.  Mapping isn't supported on
+// Windows, where open() always fails and callers should read the file
+// through a stream instead.
+class PDAL_DLL MappedFile
+{
+public:
+    MappedFile() : m_data(NULL), m_size(0)
+        {}
+    ~MappedFile()
+        { close(); }
+
+    // Map the whole file.  Return false if the file can't be mapped.
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const
+        { return m_data != NULL; }
+    const char *data() const
+        { return m_data; }
+    uintmax_t size() const
+        { return m_size; }
+
+    // Hint that the bytes in [offset, offset + length) will be read in
+    // order, so the system can read ahead and drop pages behind.
+    void adviseSequential(uintmax_t offset, uintmax_t length);
+    // Hint that the bytes in [offset, offset + length) will be read soon,
+    // so the system can start paging them in.
+    void adviseWillNeed(uintmax_t offset, uintmax_t length);
+
+private:
+    char *m_data;
+    uintmax_t m_size;
+
+    MappedFile(const MappedFile&); // not implemented
+    MappedFile& operator=(const MappedFile&); // not implemented
+};
+
+} // namespace pdal
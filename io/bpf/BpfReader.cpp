@@ -37,6 +37,7 @@
 #include <zlib.h>
 
 #include <pdal/Options.hpp>
+#include <pdal/Trace.hpp>
 #include <pdal/pdal_export.hpp>
 
 namespace pdal
@@ -53,10 +54,22 @@ CREATE_STATIC_PLUGIN(1, 0, BpfReader, Reader, s_info)
 
 std::string BpfReader::getName() const { return s_info.name; }
 
-void BpfReader::processOptions(const Options&)
+Options BpfReader::getDefaultOptions()
+{
+    Options options;
+    options.add("stride", 1, "Only read every Nth point of the file.  "
+        "Ignored unless the file is point major.");
+    return options;
+}
+
+
+void BpfReader::processOptions(const Options& options)
 {
     if (m_filename.empty())
         throw pdal_error("Can't read BPF file without filename.");
+    m_stride = options.getValueOrDefault<point_count_t>("stride", 1);
+    if (m_stride == 0)
+        throw pdal_error("Option 'stride' must be greater than zero.");
 
     // Logfile doesn't get set until options are processed.
     m_header.setLog(log());
@@ -219,8 +232,14 @@ void BpfReader::ready(PointTableRef)
 {
     m_index = 0;
     m_start = m_stream.position();
+    // Only points stored whole can be skipped, so the stride is only used
+    // when reading point major files.
+    if (m_stride > 1 && m_header.m_pointFormat != BpfFormat::PointMajor)
+        log()->get(LogLevel::Warning) << "Option 'stride' is ignored for "
+            "BPF files that aren't point major." << std::endl;
     if (m_header.m_compression)
     {
+        TraceScope trace("compress", "readers.bpf inflate");
         m_deflateBuf.resize(numPoints() * m_dims.size() * sizeof(float));
         size_t index = 0;
         size_t bytesRead = 0;
@@ -310,7 +329,10 @@ point_count_t BpfReader::readPointMajor(PointViewPtr data, point_count_t count)
         if (m_cb)
             m_cb(*data, nextId);
 
-        idx++;
+        // Skip the points between those read.
+        idx += m_stride;
+        if (m_stride > 1 && idx < numPoints())
+            m_stream.skip((m_stride - 1) * sizeof(float) * m_dims.size());
         numRead++;
         nextId++;
     }
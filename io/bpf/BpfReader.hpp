@@ -60,6 +60,7 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    Options getDefaultOptions();
 
     virtual point_count_t numPoints() const
         {  return (point_count_t)m_header.m_numPts; }
@@ -80,6 +81,8 @@ private:
     std::vector<char> m_deflateBuf;
     /// Streambuf for deflated data.
     Charbuf m_charbuf;
+    /// Only every m_stride'th point of the file is read.
+    point_count_t m_stride;
 
     virtual void processOptions(const Options& options);
     virtual QuickInfo inspect();
@@ -35,6 +35,7 @@
 #include "BpfWriter.hpp"
 
 #include <pdal/Options.hpp>
+#include <pdal/Trace.hpp>
 #include <pdal/pdal_export.hpp>
 
 #include <zlib.h>
@@ -242,6 +243,7 @@ void BpfWriter::writePointMajor(const PointView* data)
         }
         if (m_header.m_compression)
         {
+            TraceScope trace("compress", "writers.bpf compressor flush");
             compressor.compress();
             compressor.finish();
         }
@@ -266,6 +268,7 @@ void BpfWriter::writeDimMajor(const PointView* data)
         }
         if (m_header.m_compression)
         {
+            TraceScope trace("compress", "writers.bpf compressor flush");
             compressor.compress();
             compressor.finish();
         }
@@ -301,6 +304,7 @@ void BpfWriter::writeByteMajor(const PointView* data)
     }
     if (m_header.m_compression)
     {
+        TraceScope trace("compress", "writers.bpf compressor flush");
         compressor.compress();
         compressor.finish();
     }
@@ -92,6 +92,11 @@ public:
     static Dimension::IdList getDefaultDimensions();
     Options getDefaultOptions();
 
+    // Ramp mode spreads points over the count requested in a single read,
+    // so it can't be split into chunks.
+    virtual bool streamable() const
+        { return m_mode != Ramp; }
+
 private:
     Mode m_mode;
     double m_minX;
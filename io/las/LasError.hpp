@@ -33,6 +33,7 @@
 
 #pragma once
 
+#include <mutex>
 #include <vector>
 
 #include <pdal/util/Utils.hpp>
@@ -52,9 +53,13 @@ public:
 
     void setLog(LogPtr log) { m_log = log; }
 
+    // Points may be decoded by several threads at once.
     void returnNumWarning(int returnNum)
     {
         static std::vector<int> warned;
+        static std::mutex mutex;
+
+        std::lock_guard<std::mutex> lock(mutex);
 
         if (!Utils::contains(warned, returnNum))
         {
@@ -67,6 +72,9 @@ public:
     void numReturnsWarning(int numReturns)
     {
         static std::vector<int> warned;
+        static std::mutex mutex;
+
+        std::lock_guard<std::mutex> lock(mutex);
 
         if (!Utils::contains(warned, numReturns))
         {
@@ -0,0 +1,336 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "LasIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+#include <boost/filesystem.hpp>
+
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/IStream.hpp>
+#include <pdal/util/OStream.hpp>
+
+#include "LasReader.hpp"
+
+namespace pdal
+{
+
+namespace
+{
+
+const char Magic[] = "PDXI";
+const uint32_t Version = 2;
+// Cells are split until they hold about this many points on average.
+const point_count_t CellPoints = 10000;
+const uint32_t MaxLevel = 10;
+// Ranges are merged until they hold at least this many points on average.
+const point_count_t RangePoints = 100;
+
+// Interleave the bits of a column and row to make a Morton code.
+uint32_t interleave(uint32_t x, uint32_t y)
+{
+    uint32_t code = 0;
+    for (uint32_t i = 0; i < MaxLevel; ++i)
+        code |= ((x >> i) & 1) << (2 * i) | ((y >> i) & 1) << (2 * i + 1);
+    return code;
+}
+
+
+void deinterleave(uint32_t code, uint32_t& x, uint32_t& y)
+{
+    x = y = 0;
+    for (uint32_t i = 0; i < MaxLevel; ++i)
+    {
+        x |= ((code >> (2 * i)) & 1) << i;
+        y |= ((code >> (2 * i + 1)) & 1) << i;
+    }
+}
+
+
+// Merge sorted ranges that are separated by at most 'gap' points.
+void mergeRanges(std::vector<LasIndex::Range>& ranges, point_count_t gap)
+{
+    if (ranges.empty())
+        return;
+
+    size_t out = 0;
+    for (size_t i = 1; i < ranges.size(); ++i)
+    {
+        if (ranges[i].first <= ranges[out].second + gap)
+            ranges[out].second = std::max(ranges[out].second,
+                ranges[i].second);
+        else
+            ranges[++out] = ranges[i];
+    }
+    ranges.resize(out + 1);
+}
+
+
+// Cell of a coordinate along an axis divided into 'cells' cells.  Values
+// outside the bounds belong to the first or last cell.
+uint32_t cell(double v, double min, double max, uint32_t cells)
+{
+    double width = (max - min) / cells;
+    if (!(width > 0))
+        return 0;
+    double c = std::floor((v - min) / width);
+    if (!(c > 0))
+        return 0;
+    return (uint32_t)std::min(c, (double)(cells - 1));
+}
+
+
+int64_t modTime(const std::string& filename)
+{
+    boost::system::error_code ec;
+    std::time_t t = boost::filesystem::last_write_time(filename, ec);
+    return ec ? 0 : (int64_t)t;
+}
+
+} // unnamed namespace
+
+
+LasIndex::LasIndex() : m_level(0), m_numPoints(0), m_fileSize(0),
+    m_modTime(0)
+{}
+
+
+LasIndex::LasIndex(const BOX2D& bounds, point_count_t numPoints) :
+    m_bounds(bounds), m_level(0), m_numPoints(0), m_fileSize(0),
+    m_modTime(0)
+{
+    while (m_level < MaxLevel &&
+        (numPoints >> (2 * m_level)) > CellPoints)
+        m_level++;
+    m_cells.resize((size_t)1 << (2 * m_level));
+    for (size_t i = 0; i < m_cells.size(); ++i)
+        m_cells[i].m_code = (uint32_t)i;
+}
+
+
+uint32_t LasIndex::column(double x) const
+{
+    return cell(x, m_bounds.minx, m_bounds.maxx, 1 << m_level);
+}
+
+
+uint32_t LasIndex::row(double y) const
+{
+    return cell(y, m_bounds.miny, m_bounds.maxy, 1 << m_level);
+}
+
+
+void LasIndex::add(double x, double y)
+{
+    std::vector<Range>& ranges =
+        m_cells[interleave(column(x), row(y))].m_ranges;
+    PointId idx = m_numPoints++;
+    if (ranges.size() && ranges.back().second == idx)
+        ranges.back().second++;
+    else
+        ranges.push_back(Range(idx, idx + 1));
+}
+
+
+// Reading a few points that aren't needed costs less than seeking past
+// them, so ranges separated by small gaps are merged until ranges are
+// reasonably long.  This keeps the index small for files whose points
+// aren't in spatial order.
+void LasIndex::finish()
+{
+    m_cells.erase(std::remove_if(m_cells.begin(), m_cells.end(),
+        [](const Cell& c){ return c.m_ranges.empty(); }), m_cells.end());
+
+    auto numRanges = [this]()
+    {
+        size_t count = 0;
+        for (auto& c : m_cells)
+            count += c.m_ranges.size();
+        return count;
+    };
+
+    point_count_t gap = 1;
+    while (numRanges() > m_numPoints / RangePoints + m_cells.size())
+    {
+        for (auto& c : m_cells)
+            mergeRanges(c.m_ranges, gap);
+        gap *= 2;
+    }
+}
+
+
+std::vector<LasIndex::Range> LasIndex::ranges(const BOX2D& bounds) const
+{
+    std::vector<Range> out;
+
+    uint32_t minCol = column(bounds.minx);
+    uint32_t maxCol = column(bounds.maxx);
+    uint32_t minRow = row(bounds.miny);
+    uint32_t maxRow = row(bounds.maxy);
+    for (auto& c : m_cells)
+    {
+        uint32_t x, y;
+        deinterleave(c.m_code, x, y);
+        if (x >= minCol && x <= maxCol && y >= minRow && y <= maxRow)
+            out.insert(out.end(), c.m_ranges.begin(), c.m_ranges.end());
+    }
+    std::sort(out.begin(), out.end());
+    mergeRanges(out, 0);
+    return out;
+}
+
+
+void LasIndex::create(const std::string& filename)
+{
+    Options ops;
+    ops.add("filename", filename);
+    LasReader reader;
+    reader.setOptions(ops);
+
+    // Points are streamed through a small table, so files of any size can
+    // be indexed.
+    StreamPointTable table;
+    reader.prepare(table);
+    const LasHeader& h = reader.header();
+    LasIndex index(h.getBounds().to2d(), h.pointCount());
+    reader.setReadCb([&index](PointView& view, PointId id)
+    {
+        index.add(view.getFieldAs<double>(Dimension::Id::X, id),
+            view.getFieldAs<double>(Dimension::Id::Y, id));
+    });
+    reader.execute(table);
+    index.finish();
+    index.m_fileSize = FileUtils::fileSize(filename);
+    index.m_modTime = modTime(filename);
+
+    std::string name = sidecarName(filename);
+    std::ostream *out = FileUtils::createFile(name);
+    if (!out)
+    {
+        std::ostringstream oss;
+        oss << "Unable to create index file '" << name << "'.";
+        throw pdal_error(oss.str());
+    }
+    index.write(*out);
+    FileUtils::closeFile(out);
+}
+
+
+// A file rewritten in place, as when its points are transformed, may keep
+// its size and point count, so its modification time and the bounds in
+// its header are checked as well.
+bool LasIndex::load(const std::string& filename, const LasHeader& header)
+{
+    std::string name = sidecarName(filename);
+    if (!FileUtils::fileExists(name))
+        return false;
+
+    std::istream *in = FileUtils::openFile(name);
+    if (!in)
+        return false;
+    bool ok = true;
+    try
+    {
+        read(*in);
+    }
+    catch (pdal_error&)
+    {
+        ok = false;
+    }
+    FileUtils::closeFile(in);
+    return ok && m_fileSize == FileUtils::fileSize(filename) &&
+        m_modTime == modTime(filename) &&
+        m_numPoints == header.pointCount() &&
+        m_bounds == header.getBounds().to2d();
+}
+
+
+void LasIndex::write(std::ostream& out) const
+{
+    OLeStream stream(&out);
+
+    stream.put(Magic, 4);
+    stream << Version << m_fileSize << m_modTime << (uint64_t)m_numPoints <<
+        m_bounds.minx << m_bounds.miny << m_bounds.maxx << m_bounds.maxy <<
+        m_level << (uint32_t)m_cells.size();
+    for (auto& c : m_cells)
+    {
+        stream << c.m_code << (uint32_t)c.m_ranges.size();
+        for (auto& r : c.m_ranges)
+            stream << (uint64_t)r.first << (uint64_t)r.second;
+    }
+}
+
+
+void LasIndex::read(std::istream& in)
+{
+    ILeStream stream(&in);
+
+    std::string magic;
+    uint32_t version;
+    uint64_t numPoints;
+    uint32_t numCells;
+    stream.get(magic, 4);
+    stream >> version >> m_fileSize >> m_modTime >> numPoints >>
+        m_bounds.minx >> m_bounds.miny >> m_bounds.maxx >> m_bounds.maxy >>
+        m_level >> numCells;
+    if (!in.good() || magic != Magic || version != Version ||
+        m_level > MaxLevel)
+        throw pdal_error("Invalid LAS index file.");
+    m_numPoints = numPoints;
+
+    m_cells.clear();
+    for (uint32_t i = 0; i < numCells && in.good(); ++i)
+    {
+        Cell c;
+        uint32_t numRanges;
+        stream >> c.m_code >> numRanges;
+        for (uint32_t j = 0; j < numRanges && in.good(); ++j)
+        {
+            uint64_t first, second;
+            stream >> first >> second;
+            c.m_ranges.push_back(Range(first, second));
+        }
+        m_cells.push_back(std::move(c));
+    }
+    if (!in.good())
+        throw pdal_error("Invalid LAS index file.");
+}
+
+} // namespace pdal
@@ -0,0 +1,115 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_internal.hpp>
+#include <pdal/util/Bounds.hpp>
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace pdal
+{
+
+class LasHeader;
+
+// Quadtree index of the points of a LAS/LAZ file, kept in a sidecar file
+// next to it.  The leaf cells of the tree divide the file's XY bounds into
+// a grid and list the ranges of consecutive points that fall in each cell,
+// so a reader can skip to the points near an area of interest.  Cells are
+// stored in Morton (Z) order, so the cells of any node of the tree are
+// contiguous.
+class PDAL_DLL LasIndex
+{
+public:
+    // Points from 'first' up to 'second', in file order.
+    typedef std::pair<PointId, PointId> Range;
+
+    LasIndex();
+    // Start an index of about 'numPoints' points within 'bounds'.
+    LasIndex(const BOX2D& bounds, point_count_t numPoints);
+
+    // Add the next point of the file.
+    void add(double x, double y);
+    // Merge the ranges of cells when there are many short ones.  Called
+    // once all points have been added.
+    void finish();
+
+    // Ranges of the points that may be inside 'bounds', in file order.
+    std::vector<Range> ranges(const BOX2D& bounds) const;
+    point_count_t numPoints() const
+        { return m_numPoints; }
+
+    // Name of the sidecar file of a LAS/LAZ file.
+    static std::string sidecarName(const std::string& filename)
+        { return filename + ".pdx"; }
+    // Index the points of a LAS/LAZ file and write the sidecar file.
+    static void create(const std::string& filename);
+    // Read the sidecar file of 'filename', whose header is 'header'.
+    // Returns false if there isn't one or it doesn't describe the file as
+    // it is now.
+    bool load(const std::string& filename, const LasHeader& header);
+
+    void write(std::ostream& out) const;
+    void read(std::istream& in);
+
+private:
+    struct Cell
+    {
+        Cell() : m_code(0)
+        {}
+
+        uint32_t m_code;
+        std::vector<Range> m_ranges;
+    };
+
+    BOX2D m_bounds;
+    uint32_t m_level;
+    point_count_t m_numPoints;
+    // Size and modification time of the indexed file, used with the point
+    // count and bounds to detect a stale sidecar.
+    uint64_t m_fileSize;
+    int64_t m_modTime;
+    // Leaf cells, by Morton code while building and the non-empty cells
+    // in Morton order once finished.
+    std::vector<Cell> m_cells;
+
+    uint32_t column(double x) const;
+    uint32_t row(double y) const;
+};
+
+} // namespace pdal
@@ -34,6 +34,10 @@
 
 #include "LasReader.hpp"
 
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <limits>
 #include <sstream>
 #include <string.h>
 
@@ -41,6 +45,7 @@
 #include <pdal/PDALUtils.hpp>
 #include <pdal/PointView.hpp>
 #include <pdal/QuickInfo.hpp>
+#include <pdal/Trace.hpp>
 #include <pdal/util/Extractor.hpp>
 #include <pdal/util/FileUtils.hpp>
 #include <pdal/util/IStream.hpp>
@@ -63,12 +68,39 @@ public:
         {}
 };
 
+// Wait for every thread before reporting the first error.
+void waitAll(std::vector<std::future<void>>& futures)
+{
+    std::exception_ptr error;
+    for (auto& f : futures)
+    {
+        try
+        {
+            f.get();
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
 } // unnamed namespace
 
 void LasReader::processOptions(const Options& options)
 {
     StringList extraDims = options.getValueOrDefault<StringList>("extra_dims");
     m_extraDims = LasUtils::parse(extraDims);
+    m_decodeThreads = options.getValueOrDefault<size_t>("threads", 0);
+    m_useMmap = options.getValueOrDefault<bool>("mmap", true);
+    m_compression = options.getValueOrDefault<std::string>("compression", "");
+    m_clipBounds = options.getValueOrDefault<BOX2D>("bounds", BOX2D());
+    m_stride = options.getValueOrDefault<point_count_t>("stride", 1);
+    if (m_stride == 0)
+        throw pdal_error("Option 'stride' must be greater than zero.");
 
     m_error.setFilename(m_filename);
 }
@@ -156,6 +188,20 @@ void LasReader::ready(PointTableRef table, MetadataNode& m)
 {
     m_index = 0;
 
+    // Look up where each loaded dimension is stored once, rather than for
+    // each value loaded.
+    PointLayoutPtr layout = table.layout();
+    m_dimOffsets.assign(m_loadDims.size(), 0);
+    m_dimTypes.assign(m_loadDims.size(), Dimension::Type::None);
+    for (size_t i = 0; i < m_loadDims.size(); ++i)
+    {
+        if (!m_loadDims[i])
+            continue;
+        Dimension::Id::Enum id = (Dimension::Id::Enum)i;
+        m_dimOffsets[i] = layout->dimOffset(id);
+        m_dimTypes[i] = layout->dimType(id);
+    }
+
     setSrsFromVlrs(m);
     MetadataNode forward = table.privateMetadata("lasforward");
     extractHeaderMetadata(forward, m);
@@ -163,34 +209,107 @@ void LasReader::ready(PointTableRef table, MetadataNode& m)
 
     if (m_lasHeader.compressed())
     {
+        // Any engine can decompress LAZ data, so "false" is the same as
+        // using the default.
+        LasCompression::Enum engine = LasUtils::compression(m_compression);
+        if (engine == LasCompression::None)
+            engine = defaultCompression();
+        if (engine == LasCompression::LazPerf)
+            openLazPerf();
+        else
+        {
 #ifdef PDAL_HAVE_LASZIP
-        VariableLengthRecord *vlr = findVlr(LASZIP_USER_ID, LASZIP_RECORD_ID);
-        m_zipPoint.reset(new ZipPoint(vlr));
+            VariableLengthRecord *vlr =
+                findVlr(LASZIP_USER_ID, LASZIP_RECORD_ID);
+            m_zipPoint.reset(new ZipPoint(vlr));
 
-        if (!m_unzipper)
-        {
-            m_unzipper.reset(new LASunzipper());
+            if (!m_unzipper)
+            {
+                m_unzipper.reset(new LASunzipper());
 
-            m_istream->seekg(m_lasHeader.pointOffset(), std::ios::beg);
+                m_istream->seekg(m_lasHeader.pointOffset(), std::ios::beg);
 
-            // Once we open the zipper, don't touch the stream until the
-            // zipper is closed or bad things happen.
-            if (!m_unzipper->open(*m_istream, m_zipPoint->GetZipper()))
-            {
-                std::ostringstream oss;
-                const char* err = m_unzipper->get_error();
-                if (err == NULL)
-                    err = "(unknown error)";
-                oss << "Failed to open LASzip stream: " << std::string(err);
-                throw pdal_error(oss.str());
+                // Once we open the zipper, don't touch the stream until the
+                // zipper is closed or bad things happen.
+                if (!m_unzipper->open(*m_istream, m_zipPoint->GetZipper()))
+                {
+                    std::ostringstream oss;
+                    const char* err = m_unzipper->get_error();
+                    if (err == NULL)
+                        err = "(unknown error)";
+                    oss << "Failed to open LASzip stream: " <<
+                        std::string(err);
+                    throw pdal_error(oss.str());
+                }
             }
-        }
 #else
-        throw pdal_error("LASzip is not enabled.  Can't read LAZ data.");
+            throw pdal_error("LASzip is not enabled.  Can't read LAZ data.");
 #endif
+        }
+    }
+    else if (m_useMmap && lasFile() && m_map.open(m_filename))
+    {
+        // Points are normally read from start to end.  Pages are brought in
+        // ahead of each read as well.  A stride that skips whole pages
+        // only touches the pages it reads.
+        const uintmax_t PageSize = 4096;
+        uintmax_t offset = m_lasHeader.pointOffset();
+        if (m_stride * m_lasHeader.pointLen() < PageSize)
+            m_map.adviseSequential(offset, m_map.size() - offset);
     }
     m_error.setLog(log());
 
+    // Points outside the bounds used by later stages aren't loaded.  Those
+    // stages drop the points anyway, so points aren't tested when the
+    // header bounds, widened by the scale to allow for rounding, are
+    // inside them.  The header bounds may be stale, so points are always
+    // tested against the "bounds" option, and the file is only skipped
+    // when its index has no points in bounds.
+    const LasHeader& h = m_lasHeader;
+    const BOX3D& b = h.getBounds();
+    BOX3D fileBounds(b.minx - h.scaleX(), b.miny - h.scaleY(),
+        b.minz - h.scaleZ(), b.maxx + h.scaleX(), b.maxy + h.scaleY(),
+        b.maxz + h.scaleZ());
+
+    m_bounds = boundsHint();
+    if (!m_clipBounds.empty())
+        m_bounds.clip(BOX3D(m_clipBounds.minx, m_clipBounds.miny,
+            std::numeric_limits<double>::lowest(), m_clipBounds.maxx,
+            m_clipBounds.maxy, (std::numeric_limits<double>::max)()));
+    m_cropPoints = !m_clipBounds.empty() || !m_bounds.contains(fileBounds);
+    readyIndex();
+}
+
+
+// When points are limited to bounds and the file has a current index,
+// only the ranges of points the index says may be in bounds are read.
+void LasReader::readyIndex()
+{
+    m_useIndex = false;
+    m_ranges.clear();
+    m_range = 0;
+    if (!m_cropPoints || m_index >= getNumPoints() || !lasFile())
+        return;
+
+    LasIndex index;
+    if (!index.load(m_filename, m_lasHeader))
+        return;
+#ifdef PDAL_HAVE_LAZPERF
+    // laz-perf can only seek in chunked data.
+    if (m_lazUnzipper && m_lazUnzipper->chunks().empty())
+        return;
+#endif
+
+    m_ranges = index.ranges(m_bounds.to2d());
+    m_useIndex = true;
+    point_count_t count = 0;
+    for (auto& r : m_ranges)
+        count += r.second - r.first;
+    log()->get(LogLevel::Debug) << "Index of '" << m_filename <<
+        "' limits reading to " << count << " of " << getNumPoints() <<
+        " points." << std::endl;
+    if (count == 0)
+        m_index = getNumPoints();
 }
 
 
@@ -200,6 +319,15 @@ Options LasReader::getDefaultOptions()
     options.add("filename", "", "file to read from");
     options.add("extra_dims", "", "Extra dimensions not part of the LAS "
         "point format to be read from each point.");
+    options.add("threads", 0, "Number of threads used to decode "
+        "points.  Zero uses the pipeline's thread count.");
+    options.add("mmap", true, "Decode uncompressed points directly from "
+        "the file mapped into memory.");
+    options.add("compression", "", "Library used to decompress LAZ data: "
+        "'laszip' or 'lazperf'.  Empty uses LASzip if available.");
+    options.add("bounds", BOX2D(), "Only read points inside these XY "
+        "bounds.  Uses the file's index, if it has one.");
+    options.add("stride", 1, "Only read every Nth point of the file.");
     return options;
 }
 
@@ -517,79 +645,126 @@ void LasReader::extractVlrMetadata(MetadataNode& forward, MetadataNode& m)
 }
 
 
+// Dimensions that no later stage reads aren't added to the table or
+// loaded from the file.
 void LasReader::addDimensions(PointLayoutPtr layout)
 {
     using namespace Dimension;
 
-    layout->registerDim(Id::X, Type::Double);
-    layout->registerDim(Id::Y, Type::Double);
-    layout->registerDim(Id::Z, Type::Double);
-    layout->registerDim(Id::Intensity, Type::Unsigned16);
-    layout->registerDim(Id::ReturnNumber, Type::Unsigned8);
-    layout->registerDim(Id::NumberOfReturns, Type::Unsigned8);
-    layout->registerDim(Id::ScanDirectionFlag, Type::Unsigned8);
-    layout->registerDim(Id::EdgeOfFlightLine, Type::Unsigned8);
-    layout->registerDim(Id::Classification, Type::Unsigned8);
-    layout->registerDim(Id::ScanAngleRank, Type::Float);
-    layout->registerDim(Id::UserData, Type::Unsigned8);
-    layout->registerDim(Id::PointSourceId, Type::Unsigned16);
+    m_loadDims.clear();
+    registerDim(layout, Id::X, Type::Double);
+    registerDim(layout, Id::Y, Type::Double);
+    registerDim(layout, Id::Z, Type::Double);
+    registerDim(layout, Id::Intensity, Type::Unsigned16);
+    registerDim(layout, Id::ReturnNumber, Type::Unsigned8);
+    registerDim(layout, Id::NumberOfReturns, Type::Unsigned8);
+    registerDim(layout, Id::ScanDirectionFlag, Type::Unsigned8);
+    registerDim(layout, Id::EdgeOfFlightLine, Type::Unsigned8);
+    registerDim(layout, Id::Classification, Type::Unsigned8);
+    registerDim(layout, Id::ScanAngleRank, Type::Float);
+    registerDim(layout, Id::UserData, Type::Unsigned8);
+    registerDim(layout, Id::PointSourceId, Type::Unsigned16);
 
     if (m_lasHeader.hasTime())
-        layout->registerDim(Id::GpsTime, Type::Double);
+        registerDim(layout, Id::GpsTime, Type::Double);
     if (m_lasHeader.hasColor())
     {
-        layout->registerDim(Id::Red, Type::Unsigned16);
-        layout->registerDim(Id::Green, Type::Unsigned16);
-        layout->registerDim(Id::Blue, Type::Unsigned16);
+        registerDim(layout, Id::Red, Type::Unsigned16);
+        registerDim(layout, Id::Green, Type::Unsigned16);
+        registerDim(layout, Id::Blue, Type::Unsigned16);
     }
     if (m_lasHeader.hasInfrared())
-        layout->registerDim(Id::Infrared);
+        registerDim(layout, Id::Infrared, defaultType(Id::Infrared));
     if (m_lasHeader.versionAtLeast(1, 4))
-        layout->registerDim(Id::ScanChannel);
+        registerDim(layout, Id::ScanChannel, defaultType(Id::ScanChannel));
 
     for (auto& dim : m_extraDims)
     {
         Dimension::Type::Enum type = dim.m_dimType.m_type;
-        if (type == Dimension::Type::None)
+        dim.m_dimType.m_id = Id::Unknown;
+        if (type == Dimension::Type::None || !dimensionUsed(dim.m_name))
             continue;
         if (dim.m_dimType.m_xform.nonstandard())
             type = Dimension::Type::Double;
         dim.m_dimType.m_id = layout->assignDim(dim.m_name, type);
     }
+
+    // Points take no space in a table with no dimensions, so the location
+    // is loaded when no later stage reads any dimension, as when the
+    // points are only counted.
+    bool loaded = std::find(m_loadDims.begin(), m_loadDims.end(), true) !=
+        m_loadDims.end();
+    for (auto& dim : m_extraDims)
+        loaded = loaded || dim.m_dimType.m_id != Id::Unknown;
+    if (!loaded)
+    {
+        loadDim(layout, Id::X, Type::Double);
+        loadDim(layout, Id::Y, Type::Double);
+        loadDim(layout, Id::Z, Type::Double);
+    }
 }
 
 
+void LasReader::registerDim(PointLayoutPtr layout, Dimension::Id::Enum id,
+    Dimension::Type::Enum type)
+{
+    if (dimensionUsed(id))
+        loadDim(layout, id, type);
+}
+
+
+void LasReader::loadDim(PointLayoutPtr layout, Dimension::Id::Enum id,
+    Dimension::Type::Enum type)
+{
+    layout->registerDim(id, type);
+    if (id >= m_loadDims.size())
+        m_loadDims.resize(id + 1);
+    m_loadDims[id] = true;
+}
+
+
+// Read 'count' points, after striding, starting at the current point.
+// Returns the number of points read, some of which may not be loaded if
+// they're out of bounds.
 point_count_t LasReader::read(PointViewPtr view, point_count_t count)
 {
-    size_t pointByteCount = m_lasHeader.pointLen();
     count = std::min(count, getNumPoints() - m_index);
+    if (m_useIndex)
+        return readIndexed(*view.get(), count);
+    if (m_stride > 1)
+        return readStrided(*view.get(), count, getNumPoints());
+
+    point_count_t i = readPoints(*view.get(), count);
+    m_index += i;
+    return i;
+}
+
+
+// Read 'count' points starting at the current point.  Returns the number
+// of points read, some of which may not be loaded if they're out of
+// bounds.
+point_count_t LasReader::readPoints(PointView& view, point_count_t count)
+{
+    size_t pointByteCount = m_lasHeader.pointLen();
 
     PointId i = 0;
-    if (m_zipPoint)
+    if (m_zipPoint || m_lazUnzipper)
     {
-#ifdef PDAL_HAVE_LASZIP
-        for (i = 0; i < count; i++)
-        {
-            if (!m_unzipper->read(m_zipPoint->m_lz_point))
-            {
-                std::string error = "Error reading compressed point data: ";
-                const char* err = m_unzipper->get_error();
-                if (!err)
-                    err = "(unknown error)";
-                error += err;
-                throw pdal_error(error);
-            }
-            loadPoint(*view.get(), (char *)m_zipPoint->m_lz_point_data.data(),
-                pointByteCount);
-        }
-#else
-        throw pdal_error("LASzip is not enabled for this "
-            "LasReader::processBuffer");
-#endif
+        i = readCompressed(view, count);
+    }
+    else if (useThreads(count))
+    {
+        i = readParallel(view, count, decodeThreads());
+    }
+    else if (m_map.isOpen())
+    {
+        i = readMapped(view, count);
     }
     else
     {
-        m_istream->seekg(m_lasHeader.pointOffset());
+        // We may be continuing a read, as when streaming.
+        m_istream->seekg(m_lasHeader.pointOffset() +
+            (std::streamoff)m_index * pointByteCount);
         point_count_t remaining = count;
 
         // Make a buffer at most a meg.
@@ -602,13 +777,11 @@ point_count_t LasReader::read(PointViewPtr view, point_count_t count)
             {
                 point_count_t blockPoints = readFileBlock(buf, remaining);
                 remaining -= blockPoints;
-                char *pos = buf.data();
-                while (blockPoints--)
-                {
-                    loadPoint(*view.get(), pos, pointByteCount);
-                    pos += pointByteCount;
-                    i++;
-                }
+                i += blockPoints;
+                if (m_cropPoints)
+                    blockPoints = cropFileBlock(buf, blockPoints);
+                loadPoints(view, view.addPoints(blockPoints),
+                    buf.data(), blockPoints);
             } while (remaining);
         }
         catch (std::out_of_range&)
@@ -616,11 +789,575 @@ point_count_t LasReader::read(PointViewPtr view, point_count_t count)
         catch (invalid_stream&)
         {}
     }
-    m_index += i;
     return (point_count_t)i;
 }
 
 
+// Read up to 'count' of the points before 'end' whose index is a multiple
+// of the stride, starting at the current point.  Uncompressed points in
+// between are skipped without being read.  Compressed points in between
+// are decompressed and dropped, except that chunks holding none of the
+// points read are skipped when the data is chunked.  The current point is
+// left after the last point read, or at 'end' when there are no more
+// points to read before it.  Returns the number of points read.
+point_count_t LasReader::readStrided(PointView& view, point_count_t count,
+    PointId end)
+{
+    const point_count_t BlockSize = 1024;
+    // Gaps smaller than this are read through rather than seeked over.
+    const std::streamoff MaxSkip = 65536;
+
+    size_t ptLen = m_lasHeader.pointLen();
+    bool compressed = (m_zipPoint || m_lazUnzipper);
+    point_count_t chunkSize = compressed ? compressedChunkSize() : 0;
+    std::vector<char> buf(BlockSize * ptLen);
+    std::vector<char> skipBuf;
+    point_count_t blockPoints = 0;
+
+    auto loadBlock = [&]()
+    {
+        if (m_cropPoints)
+            blockPoints = cropFileBlock(buf, blockPoints);
+        loadPoints(view, view.addPoints(blockPoints), buf.data(),
+            blockPoints);
+        blockPoints = 0;
+    };
+
+    // The next point read from the file or decompressor.
+    PointId pos = m_index;
+    if (!compressed && !m_map.isOpen())
+        m_istream->seekg(m_lasHeader.pointOffset() +
+            (std::streamoff)pos * ptLen);
+    PointId next = (m_index + m_stride - 1) / m_stride * m_stride;
+    point_count_t numRead = 0;
+    bool truncated = false;
+    for (; numRead < count && next < end; next += m_stride)
+    {
+        char *dst = buf.data() + blockPoints * ptLen;
+        if (compressed)
+        {
+            if (chunkSize && next / chunkSize != pos / chunkSize)
+                seekCompressed(next);
+            else
+            {
+                skipBuf.resize(std::min(next - pos, BlockSize) * ptLen);
+                for (point_count_t skip = next - pos; skip; )
+                {
+                    point_count_t num = std::min(skip, BlockSize);
+                    decompressBlock(skipBuf.data(), num);
+                    skip -= num;
+                }
+            }
+            decompressBlock(dst, 1);
+        }
+        else if (m_map.isOpen())
+        {
+            uintmax_t start = m_lasHeader.pointOffset() +
+                (uintmax_t)next * ptLen;
+            if (start + ptLen > m_map.size())
+            {
+                truncated = true;
+                break;
+            }
+            memcpy(dst, m_map.data() + start, ptLen);
+        }
+        else
+        {
+            std::streamoff skip = (std::streamoff)(next - pos) * ptLen;
+            if (skip >= MaxSkip)
+                m_istream->seekg(skip, std::istream::cur);
+            else if (skip)
+                m_istream->ignore(skip);
+            m_istream->read(dst, ptLen);
+            if (m_istream->gcount() != (std::streamsize)ptLen)
+            {
+                truncated = true;
+                break;
+            }
+        }
+        pos = next + 1;
+        numRead++;
+        if (++blockPoints == BlockSize)
+            loadBlock();
+    }
+    loadBlock();
+
+    // Nothing more is read from a truncated file.
+    if (truncated)
+        m_index = getNumPoints();
+    else if (next >= end)
+        m_index = end;
+    else
+        m_index = pos;
+    return numRead;
+}
+
+
+// Read only the ranges of points that may be in bounds.  'count' limits
+// the number of points read, after striding, rather than the number
+// loaded.
+point_count_t LasReader::readIndexed(PointView& view, point_count_t count)
+{
+    point_count_t total = 0;
+    while (total < count && m_range < m_ranges.size())
+    {
+        const LasIndex::Range& r = m_ranges[m_range];
+        point_count_t end = std::min<point_count_t>(r.second, getNumPoints());
+        if (m_index >= end)
+        {
+            m_range++;
+            continue;
+        }
+        if (m_index < r.first)
+            seekPoint(r.first);
+        if (m_stride > 1)
+        {
+            // A truncated file leaves the current point past every range.
+            total += readStrided(view, count - total, end);
+            if (m_index >= end)
+                m_range++;
+            continue;
+        }
+        point_count_t num = std::min(count - total, end - m_index);
+        point_count_t read = readPoints(view, num);
+        m_index += read;
+        total += read;
+        // Stop at the end of a truncated file.
+        if (read < num)
+            m_range = m_ranges.size();
+        else if (m_index >= end)
+            m_range++;
+    }
+    if (m_range >= m_ranges.size())
+        m_index = getNumPoints();
+    return total;
+}
+
+
+// Continue reading at 'point'.  Compressed points are read in order, so
+// the decompressor is moved as well.
+void LasReader::seekPoint(PointId point)
+{
+    seekCompressed(point);
+    m_index = point;
+}
+
+
+// Move the decompressor, if there is one, to 'point'.
+void LasReader::seekCompressed(PointId point)
+{
+#ifdef PDAL_HAVE_LAZPERF
+    if (m_lazUnzipper)
+        m_lazUnzipper->seek(point);
+#endif
+#ifdef PDAL_HAVE_LASZIP
+    if (m_unzipper && !m_unzipper->seek((unsigned int)point))
+    {
+        std::string error = "Error seeking in compressed point data: ";
+        const char* err = m_unzipper->get_error();
+        if (!err)
+            err = "(unknown error)";
+        error += err;
+        throw pdal_error(error);
+    }
+#endif
+}
+
+
+// Number of points in each chunk of compressed data that can be skipped
+// by seeking.  Zero if the data can't be skipped a chunk at a time.
+point_count_t LasReader::compressedChunkSize()
+{
+#ifdef PDAL_HAVE_LAZPERF
+    if (m_lazUnzipper)
+        return m_lazUnzipper->chunks().empty() ? 0 :
+            m_lazUnzipper->vlr().chunkSize();
+#endif
+    VariableLengthRecord *vlr = findVlr(LASZIP_USER_ID, LASZIP_RECORD_ID);
+    if (!vlr)
+        return 0;
+    LazVlr lazVlr(vlr->data(), vlr->dataLen());
+    if (lazVlr.compressor() != LazVlr::PointwiseChunked ||
+        lazVlr.chunkSize() == (std::numeric_limits<uint32_t>::max)())
+        return 0;
+    return lazVlr.chunkSize();
+}
+
+
+size_t LasReader::decodeThreads() const
+{
+    return m_decodeThreads ? m_decodeThreads : threads();
+}
+
+
+// Points are only decoded in parallel when each thread can open the file
+// itself and every point read is added to the view in order.  Small reads
+// aren't worth starting threads for.
+bool LasReader::useThreads(point_count_t count) const
+{
+    const point_count_t MinThreadPoints = 10000;
+
+    size_t threads = decodeThreads();
+    return threads > 1 && lasFile() && !m_cropPoints && !m_cb &&
+        count >= threads * MinThreadPoints;
+}
+
+
+// Run the tasks on the reader's thread pool and wait for all of them
+// before reporting the first error, since they load points into the
+// caller's view.  The pool is kept for later reads, so reading a stream
+// a chunk at a time doesn't start threads for each chunk.
+void LasReader::runTasks(const std::vector<std::function<void()>>& tasks)
+{
+    typedef std::packaged_task<void()> Task;
+
+    if (!m_pool)
+        m_pool.reset(new ThreadPool(decodeThreads()));
+
+    std::vector<std::future<void>> futures;
+    for (auto const& t : tasks)
+    {
+        auto task = std::make_shared<Task>(t);
+        futures.push_back(task->get_future());
+        m_pool->add([task](){ (*task)(); });
+    }
+    waitAll(futures);
+}
+
+
+// Split the points to be read into a range for each thread.  Each thread
+// loads its points into IDs that were added to the view up front, either
+// from the mapped file or through its own stream on the file, so threads
+// never share a stream or a point.
+point_count_t LasReader::readParallel(PointView& view, point_count_t count,
+    size_t threads)
+{
+    size_t ptLen = m_lasHeader.pointLen();
+
+    // Don't read past the end of a truncated file.
+    uintmax_t size = m_map.isOpen() ? m_map.size() :
+        FileUtils::fileSize(m_filename);
+    uintmax_t start = m_lasHeader.pointOffset() + (uintmax_t)m_index * ptLen;
+    point_count_t avail = size > start ? (size - start) / ptLen : 0;
+    count = std::min(count, avail);
+    if (count == 0)
+        return 0;
+    m_map.adviseWillNeed(start, (uintmax_t)count * ptLen);
+
+    PointId firstId = view.addPoints(count);
+    point_count_t chunk = count / threads;
+
+    std::vector<std::function<void()>> tasks;
+    point_count_t begin = 0;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        point_count_t num = (t == threads - 1) ? count - begin : chunk;
+        tasks.push_back(std::bind(&LasReader::readRange, this,
+            std::ref(view), firstId + begin, begin, num));
+        begin += num;
+    }
+    runTasks(tasks);
+    return count;
+}
+
+
+// Decode points straight from the mapped file, with no copy into a read
+// buffer.  Points past the end of a truncated file aren't read.
+point_count_t LasReader::readMapped(PointView& view, point_count_t count)
+{
+    size_t ptLen = m_lasHeader.pointLen();
+    uintmax_t start = m_lasHeader.pointOffset() + (uintmax_t)m_index * ptLen;
+    point_count_t avail = m_map.size() > start ?
+        (m_map.size() - start) / ptLen : 0;
+    count = std::min(count, avail);
+    m_map.adviseWillNeed(start, (uintmax_t)count * ptLen);
+
+    const char *pos = m_map.data() + start;
+    if (m_cropPoints)
+    {
+        // Load each run of consecutive points that are in bounds.
+        point_count_t i = 0;
+        while (i < count)
+        {
+            point_count_t first = i;
+            while (i < count && pointInBounds(pos + i * ptLen, ptLen))
+                i++;
+            if (i > first)
+                loadPoints(view, view.addPoints(i - first),
+                    pos + first * ptLen, i - first);
+            i++;
+        }
+    }
+    else
+        loadPoints(view, view.addPoints(count), pos, count);
+    return count;
+}
+
+
+// Whole chunks of chunked LAZ data are decompressed in parallel when
+// laz-perf is used and threads are enabled.  Other points are decompressed
+// in order.
+point_count_t LasReader::readCompressed(PointView& view, point_count_t count)
+{
+    TraceScope trace("compress", "readers.las decompress");
+
+    point_count_t remaining = count;
+#ifdef PDAL_HAVE_LAZPERF
+    if (m_lazUnzipper && m_lazUnzipper->chunks().size())
+    {
+        // Finish a chunk that's been started before reading whole chunks.
+        point_count_t chunkSize = m_lazUnzipper->vlr().chunkSize();
+        point_count_t lead = std::min(remaining,
+            (chunkSize - m_index % chunkSize) % chunkSize);
+        decompressPoints(view, lead);
+        remaining -= lead;
+
+        // The last chunk of the data may be short.
+        point_count_t begin = m_index + lead;
+        point_count_t end = begin + remaining;
+        size_t first = begin / chunkSize;
+        size_t last = (end == getNumPoints()) ?
+            (end + chunkSize - 1) / chunkSize : end / chunkSize;
+        last = std::min(last, m_lazUnzipper->chunks().size());
+        point_count_t chunkPoints = (last > first) ?
+            std::min<point_count_t>(last * chunkSize, end) - begin : 0;
+        if (last - first > 1 && useThreads(chunkPoints))
+        {
+            readChunks(view, first, last, chunkPoints);
+            m_lazUnzipper->seekChunk(last);
+            remaining -= chunkPoints;
+        }
+    }
+#endif
+    decompressPoints(view, remaining);
+    return count;
+}
+
+
+// Decompress points a block at a time and load those that are in bounds.
+void LasReader::decompressPoints(PointView& view, point_count_t count)
+{
+    const point_count_t BlockSize = 1024;
+    size_t ptLen = m_lasHeader.pointLen();
+    std::vector<char> buf(std::min(count, BlockSize) * ptLen);
+
+    point_count_t remaining = count;
+    while (remaining)
+    {
+        point_count_t blockPoints = std::min(remaining, BlockSize);
+        decompressBlock(buf.data(), blockPoints);
+        remaining -= blockPoints;
+        if (m_cropPoints)
+            blockPoints = cropFileBlock(buf, blockPoints);
+        loadPoints(view, view.addPoints(blockPoints), buf.data(),
+            blockPoints);
+    }
+}
+
+
+// Split the chunks from 'first' up to 'last' into a run of chunks for each
+// thread.  As when decoding uncompressed points in parallel, each thread
+// reads through its own stream and loads its points into IDs that were
+// added to the view up front.
+void LasReader::readChunks(PointView& view, size_t first, size_t last,
+    point_count_t count)
+{
+#ifdef PDAL_HAVE_LAZPERF
+    size_t numChunks = last - first;
+    size_t threads = std::min(decodeThreads(), numChunks);
+    point_count_t chunkSize = m_lazUnzipper->vlr().chunkSize();
+
+    PointId firstId = view.addPoints(count);
+
+    std::vector<std::function<void()>> tasks;
+    size_t begin = first;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        size_t num = numChunks / threads + (t < numChunks % threads ? 1 : 0);
+        tasks.push_back(std::bind(&LasReader::decompressChunks, this,
+            std::ref(view), firstId + (begin - first) * chunkSize, begin,
+            begin + num));
+        begin += num;
+    }
+    runTasks(tasks);
+#endif
+}
+
+
+// Decompress the chunks from 'first' up to 'last' into the view IDs
+// starting at 'firstId'.
+void LasReader::decompressChunks(PointView& view, PointId firstId,
+    size_t first, size_t last)
+{
+#ifdef PDAL_HAVE_LAZPERF
+    const LazVlr& vlr = m_lazUnzipper->vlr();
+    const std::vector<LazPerfUnzipper::Chunk>& chunks =
+        m_lazUnzipper->chunks();
+    point_count_t chunkSize = vlr.chunkSize();
+    size_t ptLen = m_lasHeader.pointLen();
+
+    std::istream *in = FileUtils::openFile(m_filename);
+    if (!in)
+    {
+        std::ostringstream oss;
+        oss << "Unable to open '" << m_filename << "' for reading.";
+        throw pdal_error(oss.str());
+    }
+
+    std::vector<char> data;
+    std::vector<char> buf(chunkSize * ptLen);
+    PointId nextId = firstId;
+    for (size_t c = first; c < last; ++c)
+    {
+        const LazPerfUnzipper::Chunk& chunk = chunks[c];
+        point_count_t num = std::min<point_count_t>(chunkSize,
+            getNumPoints() - c * chunkSize);
+        data.resize(chunk.m_size);
+        {
+            TraceScope trace("io", "readers.las read chunk");
+            in->seekg(chunk.m_offset);
+            in->read(data.data(), chunk.m_size);
+        }
+        if (in->gcount() != (std::streamsize)chunk.m_size)
+        {
+            FileUtils::closeFile(in);
+            std::ostringstream oss;
+            oss << "Unable to read LAZ chunk from '" << m_filename << "'.";
+            throw pdal_error(oss.str());
+        }
+        {
+            TraceScope trace("compress", "readers.las decompress chunk");
+            LazPerfUnzipper::decompressChunk(vlr, data.data(), data.size(),
+                buf.data(), num);
+        }
+        loadPoints(view, nextId, buf.data(), num);
+        nextId += num;
+    }
+    FileUtils::closeFile(in);
+#endif
+}
+
+
+void LasReader::decompressBlock(char *buf, point_count_t count)
+{
+#ifdef PDAL_HAVE_LAZPERF
+    if (m_lazUnzipper)
+    {
+        m_lazUnzipper->read(buf, count);
+        return;
+    }
+#endif
+#ifdef PDAL_HAVE_LASZIP
+    size_t ptLen = m_lasHeader.pointLen();
+    for (point_count_t i = 0; i < count; ++i, buf += ptLen)
+    {
+        if (!m_unzipper->read(m_zipPoint->m_lz_point))
+        {
+            std::string error = "Error reading compressed point data: ";
+            const char* err = m_unzipper->get_error();
+            if (!err)
+                err = "(unknown error)";
+            error += err;
+            throw pdal_error(error);
+        }
+        memcpy(buf, m_zipPoint->m_lz_point_data.data(), ptLen);
+    }
+#endif
+}
+
+
+// LASzip is used if it's available, except that laz-perf is preferred for
+// chunked data it supports when threads are enabled, since its chunks can
+// be decompressed in parallel.
+LasCompression::Enum LasReader::defaultCompression()
+{
+#ifdef PDAL_HAVE_LAZPERF
+    VariableLengthRecord *vlr = findVlr(LASZIP_USER_ID, LASZIP_RECORD_ID);
+    if (vlr && decodeThreads() > 1 && lasFile())
+    {
+        LazVlr lazVlr(vlr->data(), vlr->dataLen());
+        if (lazVlr.compressor() == LazVlr::PointwiseChunked &&
+            lazVlr.chunkSize() != (std::numeric_limits<uint32_t>::max)() &&
+            lazVlr.lazPerfSupported() &&
+            lazVlr.pointLen() == m_lasHeader.pointLen())
+            return LasCompression::LazPerf;
+    }
+#endif
+    return LasUtils::compression("true");
+}
+
+
+void LasReader::openLazPerf()
+{
+#ifdef PDAL_HAVE_LAZPERF
+    if (m_lazUnzipper)
+        return;
+
+    VariableLengthRecord *vlr = findVlr(LASZIP_USER_ID, LASZIP_RECORD_ID);
+    if (!vlr)
+        throw pdal_error("LASzip VLR not found.  Can't read LAZ data.");
+    LazVlr lazVlr(vlr->data(), vlr->dataLen());
+    if (lazVlr.pointLen() != m_lasHeader.pointLen())
+        throw pdal_error("Length of points described by the LASzip VLR "
+            "doesn't match the header.");
+    m_lazUnzipper.reset(new LazPerfUnzipper(*m_istream, lazVlr,
+        m_lasHeader.pointOffset()));
+#endif
+}
+
+
+// Read 'count' points starting 'begin' points after the current point
+// into the view IDs starting at 'firstId'.
+void LasReader::readRange(PointView& view, PointId firstId,
+    point_count_t begin, point_count_t count)
+{
+    size_t ptLen = m_lasHeader.pointLen();
+
+    if (m_map.isOpen())
+    {
+        const char *pos = m_map.data() + m_lasHeader.pointOffset() +
+            (uintmax_t)(m_index + begin) * ptLen;
+        loadPoints(view, firstId, pos, count);
+        return;
+    }
+
+    std::istream *in = FileUtils::openFile(m_filename);
+    if (!in)
+    {
+        std::ostringstream oss;
+        oss << "Unable to open '" << m_filename << "' for reading.";
+        throw pdal_error(oss.str());
+    }
+    in->seekg(m_lasHeader.pointOffset() +
+        (std::streamoff)(m_index + begin) * ptLen);
+
+    // Make a buffer at most a meg.
+    point_count_t blockPoints = std::max<point_count_t>(1, 1000000 / ptLen);
+    std::vector<char> buf(std::min(blockPoints, count) * ptLen);
+    PointId nextId = firstId;
+    while (count)
+    {
+        point_count_t num = std::min<point_count_t>(count,
+            buf.size() / ptLen);
+        {
+            TraceScope trace("io", "readers.las read block");
+            in->read(buf.data(), num * ptLen);
+        }
+        if (in->gcount() != (std::streamsize)(num * ptLen))
+        {
+            FileUtils::closeFile(in);
+            std::ostringstream oss;
+            oss << "Unable to read points from '" << m_filename << "'.";
+            throw pdal_error(oss.str());
+        }
+        loadPoints(view, nextId, buf.data(), num);
+        nextId += num;
+        count -= num;
+    }
+    FileUtils::closeFile(in);
+}
+
+
 point_count_t LasReader::readFileBlock(std::vector<char>& buf,
     point_count_t maxpoints)
 {
@@ -631,6 +1368,8 @@ point_count_t LasReader::readFileBlock(std::vector<char>& buf,
     if (m_istream->eof())
         throw invalid_stream("stream is done");
 
+    TraceScope trace("io", "readers.las read block");
+
     m_istream->read(buf.data(), blockpoints * ptLen);
     if (m_istream->gcount() != (std::streamsize)(blockpoints * ptLen))
     {
@@ -643,155 +1382,266 @@ point_count_t LasReader::readFileBlock(std::vector<char>& buf,
 }
 
 
-void LasReader::loadPoint(PointView& data, char *buf, size_t bufsize)
+// Move the points of a block that are inside the bounds of later stages to
+// the front of the buffer and return their count.
+point_count_t LasReader::cropFileBlock(std::vector<char>& buf,
+    point_count_t numPoints)
 {
-    if (m_lasHeader.has14Format())
-        loadPointV14(data, buf, bufsize);
-    else
-        loadPointV10(data, buf, bufsize);
+    size_t ptLen = m_lasHeader.pointLen();
+    char *in = buf.data();
+    char *out = buf.data();
+    for (point_count_t i = 0; i < numPoints; ++i, in += ptLen)
+        if (pointInBounds(in, ptLen))
+        {
+            if (out != in)
+                memmove(out, in, ptLen);
+            out += ptLen;
+        }
+    return (out - buf.data()) / ptLen;
 }
 
 
-void LasReader::loadPointV10(PointView& data, char *buf, size_t bufsize)
+bool LasReader::pointInBounds(const char *buf, size_t bufsize)
 {
     LeExtractor istream(buf, bufsize);
 
-    PointId nextId = data.size();
-
     int32_t xi, yi, zi;
     istream >> xi >> yi >> zi;
 
     const LasHeader& h = m_lasHeader;
+    return m_bounds.contains(xi * h.scaleX() + h.offsetX(),
+        yi * h.scaleY() + h.offsetY(), zi * h.scaleZ() + h.offsetZ());
+}
 
-    double x = xi * h.scaleX() + h.offsetX();
-    double y = yi * h.scaleY() + h.offsetY();
-    double z = zi * h.scaleZ() + h.offsetZ();
-
-    uint16_t intensity;
-    uint8_t flags;
-    uint8_t classification;
-    int8_t scanAngleRank;
-    uint8_t user;
-    uint16_t pointSourceId;
-
-    istream >> intensity >> flags >> classification >> scanAngleRank >>
-        user >> pointSourceId;
 
-    uint8_t returnNum = flags & 0x07;
-    uint8_t numReturns = (flags >> 3) & 0x07;
-    uint8_t scanDirFlag = (flags >> 6) & 0x01;
-    uint8_t flight = (flags >> 7) & 0x01;
+namespace
+{
 
-    if (returnNum == 0 || returnNum > 5)
-        m_error.returnNumWarning(returnNum);
+// Separate loop so that the compiler can vectorize it.
+void scaleBlock(const int32_t *in, double *out, point_count_t count,
+    double scale, double offset)
+{
+    for (point_count_t i = 0; i < count; ++i)
+        out[i] = in[i] * scale + offset;
+}
 
-    if (numReturns == 0 || numReturns > 5)
-        m_error.numReturnsWarning(numReturns);
+} // unnamed namespace
 
-    data.setField(Dimension::Id::X, nextId, x);
-    data.setField(Dimension::Id::Y, nextId, y);
-    data.setField(Dimension::Id::Z, nextId, z);
-    data.setField(Dimension::Id::Intensity, nextId, intensity);
-    data.setField(Dimension::Id::ReturnNumber, nextId, returnNum);
-    data.setField(Dimension::Id::NumberOfReturns, nextId, numReturns);
-    data.setField(Dimension::Id::ScanDirectionFlag, nextId, scanDirFlag);
-    data.setField(Dimension::Id::EdgeOfFlightLine, nextId, flight);
-    data.setField(Dimension::Id::Classification, nextId, classification);
-    data.setField(Dimension::Id::ScanAngleRank, nextId, scanAngleRank);
-    data.setField(Dimension::Id::UserData, nextId, user);
-    data.setField(Dimension::Id::PointSourceId, nextId, pointSourceId);
 
-    if (h.hasTime())
+// Store a block of values of a field into consecutive points of a view.
+// 'pts' holds the packed data of each point, if the table has it.  Values
+// are copied directly into the points when the dimension has the type of
+// the field, which is usual since the dimensions are registered with the
+// types of the LAS fields.  Otherwise they're converted by the view.
+template <typename T>
+void LasReader::storeField(PointView& view, char * const *pts,
+    Dimension::Id::Enum id, PointId firstId, const T *vals,
+    point_count_t count)
+{
+    if (pts[0] && m_dimTypes[id] == LasUtils::type<T>())
     {
-        double time;
-        istream >> time;
-        data.setField(Dimension::Id::GpsTime, nextId, time);
+        size_t offset = m_dimOffsets[id];
+        for (point_count_t i = 0; i < count; ++i)
+            memcpy(pts[i] + offset, vals + i, sizeof(T));
     }
+    else
+        for (point_count_t i = 0; i < count; ++i)
+            view.setField(id, firstId + i, vals[i]);
+}
 
-    if (h.hasColor())
+
+// Load 'count' consecutive points from 'buf'.  The points 'firstId'
+// through 'firstId' + 'count' - 1 must already exist in the view.
+void LasReader::loadPoints(PointView& view, PointId firstId, const char *buf,
+    point_count_t count)
+{
+    switch (m_lasHeader.pointFormat())
     {
-        uint16_t red, green, blue;
-        istream >> red >> green >> blue;
-        data.setField(Dimension::Id::Red, nextId, red);
-        data.setField(Dimension::Id::Green, nextId, green);
-        data.setField(Dimension::Id::Blue, nextId, blue);
+    case 0:
+        loadPoints<LasFormat<0>>(view, firstId, buf, count);
+        break;
+    case 1:
+        loadPoints<LasFormat<1>>(view, firstId, buf, count);
+        break;
+    case 2:
+        loadPoints<LasFormat<2>>(view, firstId, buf, count);
+        break;
+    case 3:
+        loadPoints<LasFormat<3>>(view, firstId, buf, count);
+        break;
+    case 6:
+        loadPoints<LasFormat<6>>(view, firstId, buf, count);
+        break;
+    case 7:
+        loadPoints<LasFormat<7>>(view, firstId, buf, count);
+        break;
+    case 8:
+        loadPoints<LasFormat<8>>(view, firstId, buf, count);
+        break;
+    default:
+    {
+        // Waveform formats are rejected when the header is read.
+        std::ostringstream oss;
+        oss << "Unsupported LAS point format " <<
+            (int)m_lasHeader.pointFormat() << ".";
+        throw pdal_error(oss.str());
+    }
     }
-
-    if (m_extraDims.size())
-        loadExtraDims(istream, data, nextId);
-    if (m_cb)
-        m_cb(data, nextId);
 }
 
-void LasReader::loadPointV14(PointView& data, char *buf, size_t bufsize)
-{
-    LeExtractor istream(buf, bufsize);
 
-    PointId nextId = data.size();
+// Points are decoded a block at a time into an array for each field, which
+// are then scaled and stored one field at a time.
+template <typename FORMAT>
+void LasReader::loadPoints(PointView& view, PointId firstId,
+    const char *buf, point_count_t count)
+{
+    using namespace Dimension;
 
-    int32_t xi, yi, zi;
-    istream >> xi >> yi >> zi;
+    const point_count_t BlockSize = 256;
 
     const LasHeader& h = m_lasHeader;
+    const size_t ptLen = h.pointLen();
+
+    int32_t xi[BlockSize], yi[BlockSize], zi[BlockSize];
+    double x[BlockSize], y[BlockSize], z[BlockSize];
+    uint16_t intensity[BlockSize];
+    uint8_t returnNum[BlockSize];
+    uint8_t numReturns[BlockSize];
+    uint8_t scanChannel[BlockSize];
+    uint8_t scanDirFlag[BlockSize];
+    uint8_t flight[BlockSize];
+    uint8_t classification[BlockSize];
+    float scanAngle[BlockSize];
+    uint8_t user[BlockSize];
+    uint16_t pointSourceId[BlockSize];
+    double gpsTime[BlockSize];
+    uint16_t red[BlockSize], green[BlockSize], blue[BlockSize];
+    uint16_t infrared[BlockSize];
+    char *pts[BlockSize];
+
+    while (count)
+    {
+        point_count_t num = std::min(count, BlockSize);
 
-    double x = xi * h.scaleX() + h.offsetX();
-    double y = yi * h.scaleY() + h.offsetY();
-    double z = zi * h.scaleZ() + h.offsetZ();
-
-    uint16_t intensity;
-    uint8_t returnInfo;
-    uint8_t flags;
-    uint8_t classification;
-    uint8_t user;
-    int16_t scanAngle;
-    uint16_t pointSourceId;
-    double gpsTime;
-
-    istream >> intensity >> returnInfo >> flags >> classification >> user >>
-        scanAngle >> pointSourceId >> gpsTime;
-
-    uint8_t returnNum = returnInfo & 0x0F;
-    uint8_t numReturns = (returnInfo >> 4) & 0x0F;
-    uint8_t classFlags = flags & 0x0F;
-    uint8_t scanChannel = (flags >> 4) & 0x03;
-    uint8_t scanDirFlag = (flags >> 6) & 0x01;
-    uint8_t flight = (flags >> 7) & 0x01;
+        const char *pos = buf;
+        for (point_count_t i = 0; i < num; ++i, pos += ptLen)
+        {
+            LeExtractor istream(pos, ptLen);
 
-    //ABELL - Need to do something with the classFlags;
-    data.setField(Dimension::Id::X, nextId, x);
-    data.setField(Dimension::Id::Y, nextId, y);
-    data.setField(Dimension::Id::Z, nextId, z);
-    data.setField(Dimension::Id::Intensity, nextId, intensity);
-    data.setField(Dimension::Id::ReturnNumber, nextId, returnNum);
-    data.setField(Dimension::Id::NumberOfReturns, nextId, numReturns);
-    data.setField(Dimension::Id::ScanChannel, nextId, scanChannel);
-    data.setField(Dimension::Id::ScanDirectionFlag, nextId, scanDirFlag);
-    data.setField(Dimension::Id::EdgeOfFlightLine, nextId, flight);
-    data.setField(Dimension::Id::Classification, nextId, classification);
-    data.setField(Dimension::Id::ScanAngleRank, nextId, scanAngle * .006);
-    data.setField(Dimension::Id::UserData, nextId, user);
-    data.setField(Dimension::Id::PointSourceId, nextId, pointSourceId);
-    data.setField(Dimension::Id::GpsTime, nextId, gpsTime);
+            istream >> xi[i] >> yi[i] >> zi[i] >> intensity[i];
+            if (FORMAT::is14)
+            {
+                uint8_t returnInfo;
+                uint8_t flags;
+                int16_t angle;
+
+                istream >> returnInfo >> flags >> classification[i] >>
+                    user[i] >> angle >> pointSourceId[i] >> gpsTime[i];
+                returnNum[i] = returnInfo & 0x0F;
+                numReturns[i] = (returnInfo >> 4) & 0x0F;
+                scanChannel[i] = (flags >> 4) & 0x03;
+                scanDirFlag[i] = (flags >> 6) & 0x01;
+                flight[i] = (flags >> 7) & 0x01;
+                scanAngle[i] = (float)(angle * .006);
+            }
+            else
+            {
+                uint8_t flags;
+                int8_t angle;
+
+                istream >> flags >> classification[i] >> angle >> user[i] >>
+                    pointSourceId[i];
+                if (FORMAT::hasTime)
+                    istream >> gpsTime[i];
+                returnNum[i] = flags & 0x07;
+                numReturns[i] = (flags >> 3) & 0x07;
+                scanDirFlag[i] = (flags >> 6) & 0x01;
+                flight[i] = (flags >> 7) & 0x01;
+                scanAngle[i] = angle;
+
+                if (returnNum[i] == 0 || returnNum[i] > 5)
+                    m_error.returnNumWarning(returnNum[i]);
+                if (numReturns[i] == 0 || numReturns[i] > 5)
+                    m_error.numReturnsWarning(numReturns[i]);
+            }
+            if (FORMAT::hasColor)
+                istream >> red[i] >> green[i] >> blue[i];
+            if (FORMAT::hasInfrared)
+                istream >> infrared[i];
+        }
 
-    if (h.hasColor())
-    {
-        uint16_t red, green, blue;
-        istream >> red >> green >> blue;
-        data.setField(Dimension::Id::Red, nextId, red);
-        data.setField(Dimension::Id::Green, nextId, green);
-        data.setField(Dimension::Id::Blue, nextId, blue);
-    }
+        scaleBlock(xi, x, num, h.scaleX(), h.offsetX());
+        scaleBlock(yi, y, num, h.scaleY(), h.offsetY());
+        scaleBlock(zi, z, num, h.scaleZ(), h.offsetZ());
+
+        for (point_count_t i = 0; i < num; ++i)
+            pts[i] = view.getPoint(firstId + i);
+
+        if (loads(Id::X))
+            storeField(view, pts, Id::X, firstId, x, num);
+        if (loads(Id::Y))
+            storeField(view, pts, Id::Y, firstId, y, num);
+        if (loads(Id::Z))
+            storeField(view, pts, Id::Z, firstId, z, num);
+        if (loads(Id::Intensity))
+            storeField(view, pts, Id::Intensity, firstId, intensity, num);
+        if (loads(Id::ReturnNumber))
+            storeField(view, pts, Id::ReturnNumber, firstId, returnNum, num);
+        if (loads(Id::NumberOfReturns))
+            storeField(view, pts, Id::NumberOfReturns, firstId, numReturns,
+                num);
+        if (FORMAT::is14 && loads(Id::ScanChannel))
+            storeField(view, pts, Id::ScanChannel, firstId, scanChannel, num);
+        if (loads(Id::ScanDirectionFlag))
+            storeField(view, pts, Id::ScanDirectionFlag, firstId,
+                scanDirFlag, num);
+        if (loads(Id::EdgeOfFlightLine))
+            storeField(view, pts, Id::EdgeOfFlightLine, firstId, flight, num);
+        if (loads(Id::Classification))
+            storeField(view, pts, Id::Classification, firstId,
+                classification, num);
+        if (loads(Id::ScanAngleRank))
+            storeField(view, pts, Id::ScanAngleRank, firstId, scanAngle, num);
+        if (loads(Id::UserData))
+            storeField(view, pts, Id::UserData, firstId, user, num);
+        if (loads(Id::PointSourceId))
+            storeField(view, pts, Id::PointSourceId, firstId,
+                pointSourceId, num);
+        if (FORMAT::hasTime && loads(Id::GpsTime))
+            storeField(view, pts, Id::GpsTime, firstId, gpsTime, num);
+        if (FORMAT::hasColor)
+        {
+            if (loads(Id::Red))
+                storeField(view, pts, Id::Red, firstId, red, num);
+            if (loads(Id::Green))
+                storeField(view, pts, Id::Green, firstId, green, num);
+            if (loads(Id::Blue))
+                storeField(view, pts, Id::Blue, firstId, blue, num);
+        }
+        if (FORMAT::hasInfrared && loads(Id::Infrared))
+            storeField(view, pts, Id::Infrared, firstId, infrared, num);
 
-    if (h.hasInfrared())
-    {
-        uint16_t nearInfraRed;
+        if (m_extraDims.size() || m_cb)
+        {
+            pos = buf;
+            for (point_count_t i = 0; i < num; ++i, pos += ptLen)
+            {
+                if (m_extraDims.size())
+                {
+                    LeExtractor istream(pos, ptLen);
+                    istream.skip(FORMAT::size);
+                    loadExtraDims(istream, view, firstId + i);
+                }
+                if (m_cb)
+                    m_cb(view, firstId + i);
+            }
+        }
 
-        istream >> nearInfraRed;
-        data.setField(Dimension::Id::Infrared, nextId, nearInfraRed);
+        buf += num * ptLen;
+        firstId += num;
+        count -= num;
     }
-
-    if (m_extraDims.size())
-        loadExtraDims(istream, data, nextId);
 }
 
 
@@ -801,8 +1651,9 @@ void LasReader::loadExtraDims(LeExtractor& istream, PointView& data,
     Everything e;
     for (auto& dim : m_extraDims)
     {
-        // Dimension type of None is undefined and unprocessed
-        if (dim.m_dimType.m_type == Dimension::Type::None)
+        // Dimension type of None is undefined and unprocessed.  Unused
+        // dimensions aren't registered.
+        if (dim.m_dimType.m_id == Dimension::Id::Unknown)
         {
             istream.skip(dim.m_size);
             continue;
@@ -829,7 +1680,12 @@ void LasReader::done(PointTableRef)
     m_zipPoint.reset();
     m_unzipper.reset();
 #endif
+#ifdef PDAL_HAVE_LAZPERF
+    m_lazUnzipper.reset();
+#endif
+    m_map.close();
     destroyStream();
+    m_pool.reset();
     m_initialized = false;
 }
 
@@ -36,10 +36,14 @@
 
 #include <pdal/pdal_export.hpp>
 #include <pdal/Reader.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <pdal/util/MappedFile.hpp>
 
 #include "LasError.hpp"
 #include "LasHeader.hpp"
+#include "LasIndex.hpp"
 #include "LasUtils.hpp"
+#include "LazPerf.hpp"
 #include "ZipPoint.hpp"
 
 extern "C" int32_t LasReader_ExitFunc();
@@ -58,7 +62,8 @@ class PDAL_DLL LasReader : public pdal::Reader
     friend class NitfReader;
 public:
     LasReader() : pdal::Reader(), m_index(0), m_istream(NULL),
-        m_initialized(false)
+        m_cropPoints(false), m_useIndex(false), m_range(0), m_stride(1),
+        m_decodeThreads(0), m_useMmap(true), m_initialized(false)
         {}
 
     virtual ~LasReader()
@@ -71,6 +76,8 @@ public:
 
     const LasHeader& header() const
         { return m_lasHeader; }
+    virtual bool streamable() const
+        { return true; }
     point_count_t getNumPoints() const
         { return m_lasHeader.pointCount(); }
 
@@ -96,20 +103,63 @@ protected:
             m_initialized = false;
         }
     }
+    // Whether the point data can be read by opening m_filename directly,
+    // as is done by each thread when points are decoded in parallel.
+    virtual bool lasFile() const
+        { return true; }
 
 private:
     LasError m_error;
     LasHeader m_lasHeader;
     std::unique_ptr<ZipPoint> m_zipPoint;
     std::unique_ptr<LASunzipper> m_unzipper;
+    std::unique_ptr<LazPerfUnzipper> m_lazUnzipper;
+    // Name of the engine used to decompress LAZ data.  Empty means use
+    // the default.
+    std::string m_compression;
     point_count_t m_index;
     std::istream* m_istream;
     VlrList m_vlrs;
     std::vector<ExtraDim> m_extraDims;
+    // Whether each standard dimension is loaded into the point table, and
+    // the offset and type of those that are, looked up when reading starts.
+    std::vector<bool> m_loadDims;
+    std::vector<size_t> m_dimOffsets;
+    std::vector<Dimension::Type::Enum> m_dimTypes;
+    // Bounds of the points used by later stages, and whether points must
+    // be tested against them.
+    BOX3D m_bounds;
+    bool m_cropPoints;
+    // Bounds of the points to read, from the "bounds" option.  Empty if
+    // points aren't limited by the option.
+    BOX2D m_clipBounds;
+    // When the file has an index, only the ranges of points that may be
+    // in bounds are read.  m_range is the range being read.
+    bool m_useIndex;
+    std::vector<LasIndex::Range> m_ranges;
+    size_t m_range;
+    // Only every m_stride'th point of the file is read.
+    point_count_t m_stride;
+    // Number of threads used to decode points.  Zero means
+    // use the stage's thread count.
+    size_t m_decodeThreads;
+    // Threads that decode points, started by the first read that uses
+    // them and kept for later reads.
+    std::unique_ptr<ThreadPool> m_pool;
+    // Uncompressed point data is decoded directly from the mapped file
+    // when mapping is enabled and supported.
+    bool m_useMmap;
+    MappedFile m_map;
 
     virtual void processOptions(const Options& options);
     virtual void initialize();
     virtual void addDimensions(PointLayoutPtr layout);
+    void registerDim(PointLayoutPtr layout, Dimension::Id::Enum id,
+        Dimension::Type::Enum type);
+    void loadDim(PointLayoutPtr layout, Dimension::Id::Enum id,
+        Dimension::Type::Enum type);
+    bool loads(Dimension::Id::Enum id) const
+        { return id < m_loadDims.size() && m_loadDims[id]; }
     void fixupVlrs();
     VariableLengthRecord *findVlr(const std::string& userId, uint16_t recordId);
     void setSrsFromVlrs(MetadataNode& m);
@@ -127,13 +177,47 @@ private:
     virtual void done(PointTableRef table);
     virtual bool eof()
         { return m_index >= getNumPoints(); }
-    void loadPoint(PointView& data, char *buf, size_t bufsize);
-    void loadPointV10(PointView& data, char *buf, size_t bufsize);
-    void loadPointV14(PointView& data, char *buf, size_t bufsize);
+    void loadPoints(PointView& view, PointId firstId, const char *buf,
+        point_count_t count);
+    template <typename FORMAT>
+    void loadPoints(PointView& view, PointId firstId, const char *buf,
+        point_count_t count);
+    template <typename T>
+    void storeField(PointView& view, char * const *pts,
+        Dimension::Id::Enum id, PointId firstId, const T *vals,
+        point_count_t count);
     void loadExtraDims(LeExtractor& istream, PointView& data, PointId nextId);
+    size_t decodeThreads() const;
+    bool useThreads(point_count_t count) const;
+    void runTasks(const std::vector<std::function<void()>>& tasks);
+    point_count_t readParallel(PointView& view, point_count_t count,
+        size_t threads);
+    point_count_t readMapped(PointView& view, point_count_t count);
+    point_count_t readPoints(PointView& view, point_count_t count);
+    point_count_t readIndexed(PointView& view, point_count_t count);
+    point_count_t readStrided(PointView& view, point_count_t count,
+        PointId end);
+    void seekPoint(PointId point);
+    void seekCompressed(PointId point);
+    point_count_t compressedChunkSize();
+    void readyIndex();
+    point_count_t readCompressed(PointView& view, point_count_t count);
+    void decompressPoints(PointView& view, point_count_t count);
+    void decompressBlock(char *buf, point_count_t count);
+    void readChunks(PointView& view, size_t first, size_t last,
+        point_count_t count);
+    void decompressChunks(PointView& view, PointId firstId, size_t first,
+        size_t last);
+    LasCompression::Enum defaultCompression();
+    void openLazPerf();
+    void readRange(PointView& view, PointId firstId, point_count_t begin,
+        point_count_t count);
     point_count_t readFileBlock(
             std::vector<char>& buf,
             point_count_t maxPoints);
+    point_count_t cropFileBlock(std::vector<char>& buf,
+        point_count_t numPoints);
+    bool pointInBounds(const char *buf, size_t bufsize);
 
     LasReader& operator=(const LasReader&); // not implemented
     LasReader(const LasReader&); // not implemented
@@ -214,6 +214,51 @@ std::vector<ExtraDim> parse(const StringList& dimString)
     return extraDims;
 }
 
+
+// Parse the value of a 'compression' option: "laszip", "lazperf", or a
+// boolean, where true selects LASzip if PDAL was built with it and
+// laz-perf otherwise.  Throws if the library isn't available.
+LasCompression::Enum compression(const std::string& s)
+{
+    std::string val = Utils::tolower(s);
+    Utils::trim(val);
+
+    LasCompression::Enum c;
+    if (val.empty() || val == "false")
+        return LasCompression::None;
+    else if (val == "laszip")
+        c = LasCompression::LasZip;
+    else if (val == "lazperf")
+        c = LasCompression::LazPerf;
+    else if (val == "true")
+    {
+#if defined(PDAL_HAVE_LASZIP) || !defined(PDAL_HAVE_LAZPERF)
+        c = LasCompression::LasZip;
+#else
+        c = LasCompression::LazPerf;
+#endif
+    }
+    else
+    {
+        std::ostringstream oss;
+        oss << "Invalid compression '" << s << "'.  Must be 'laszip', "
+            "'lazperf', 'true' or 'false'.";
+        throw pdal_error(oss.str());
+    }
+
+#ifndef PDAL_HAVE_LASZIP
+    if (c == LasCompression::LasZip)
+        throw pdal_error("Can't compress or decompress LAZ data with "
+            "LASzip.  PDAL not built with LASzip.");
+#endif
+#ifndef PDAL_HAVE_LAZPERF
+    if (c == LasCompression::LazPerf)
+        throw pdal_error("Can't compress or decompress LAZ data with "
+            "laz-perf.  PDAL not built with laz-perf.");
+#endif
+    return c;
+}
+
 } // namespace LasUtils
 
 } // namespace pdal
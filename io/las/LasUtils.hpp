@@ -125,10 +125,67 @@ private:
     size_t m_size;
 };
 
+// Library used to compress and decompress LAZ points.
+namespace LasCompression
+{
+
+enum Enum
+{
+    None,
+    LasZip,
+    LazPerf
+};
+
+} // namespace LasCompression
+
+// Fields of a LAS point format, known at compile time so that the point
+// decode and encode loops can be specialized for each format.
+template <int FORMAT>
+struct LasFormat
+{
+    static const bool is14 = FORMAT > 5;
+    static const bool hasTime = FORMAT == 1 || FORMAT >= 3;
+    static const bool hasColor = FORMAT == 2 || FORMAT == 3 || FORMAT == 5 ||
+        FORMAT == 7 || FORMAT == 8 || FORMAT == 10;
+    static const bool hasInfrared = FORMAT == 8 || FORMAT == 10;
+    static const bool hasWave = FORMAT == 4 || FORMAT == 5 || FORMAT == 9 ||
+        FORMAT == 10;
+    // Size of the standard fields, which are followed by any extra bytes.
+    static const size_t size = (is14 ? 30 : 20) + (!is14 && hasTime ? 8 : 0) +
+        (hasColor ? 6 : 0) + (hasInfrared ? 2 : 0) + (hasWave ? 29 : 0);
+};
+
 namespace LasUtils
 {
 
 std::vector<ExtraDim> parse(const StringList& dimString);
+LasCompression::Enum compression(const std::string& s);
+
+// Dimension type of the C++ types used for LAS fields.
+template <typename T>
+Dimension::Type::Enum type();
+
+template <>
+inline Dimension::Type::Enum type<uint8_t>()
+    { return Dimension::Type::Unsigned8; }
+template <>
+inline Dimension::Type::Enum type<int8_t>()
+    { return Dimension::Type::Signed8; }
+template <>
+inline Dimension::Type::Enum type<uint16_t>()
+    { return Dimension::Type::Unsigned16; }
+template <>
+inline Dimension::Type::Enum type<int16_t>()
+    { return Dimension::Type::Signed16; }
+template <>
+inline Dimension::Type::Enum type<int32_t>()
+    { return Dimension::Type::Signed32; }
+template <>
+inline Dimension::Type::Enum type<float>()
+    { return Dimension::Type::Float; }
+template <>
+inline Dimension::Type::Enum type<double>()
+    { return Dimension::Type::Double; }
 
 } // namespace LasUtils
 
@@ -34,12 +34,20 @@
 
 #include "LasWriter.hpp"
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
 #include <type_traits>
 #include <boost/uuid/uuid_generators.hpp>
 #include <iostream>
 
 #include <pdal/PDALUtils.hpp>
 #include <pdal/PointView.hpp>
+#include <pdal/Trace.hpp>
 #include <pdal/util/Inserter.hpp>
 #include <pdal/util/OStream.hpp>
 #include <pdal/util/Utils.hpp>
@@ -61,7 +69,10 @@ CREATE_STATIC_PLUGIN(1, 0, LasWriter, Writer, s_info)
 
 std::string LasWriter::getName() const { return s_info.name; }
 
-LasWriter::LasWriter() : m_ostream(NULL)
+LasWriter::LasWriter() : m_compression(LasCompression::None),
+    m_chooseCompression(false), m_compressThreads(0), m_writeBuffers(1),
+    m_dropCache(false), m_cacheStart(0), m_cacheAdvised(0), m_cacheEnd(0),
+    m_ostream(NULL)
 {
     m_majorVersion.setDefault(1);
     m_minorVersion.setDefault(2);
@@ -94,7 +105,15 @@ Options LasWriter::getDefaultOptions()
     LasHeader header;
 
     options.add("filename", "", "Name of the file for LAS/LAZ output.");
-    options.add("compression", false, "Do we LASzip-compress the data?");
+    options.add("compression", false, "Compress the data as LAZ with "
+        "'laszip' or 'lazperf'.  True uses LASzip if available.");
+    options.add("threads", 0, "Number of threads used to compress "
+        "points with laz-perf.  Zero uses the pipeline's thread count.");
+    options.add("write_buffers", 1, "Number of buffers of uncompressed "
+        "points.  With more than one, points are written by a background "
+        "thread while the next buffer is filled.");
+    options.add("drop_cache", false, "Tell the system that written points "
+        "won't be read again, so they aren't kept in the page cache.");
     options.add("major_version", 1, "LAS Major version");
     options.add("minor_version", 2, "LAS Minor version");
     options.add("dataformat_id", 3, "Point format to write");
@@ -120,21 +139,36 @@ Options LasWriter::getDefaultOptions()
 }
 
 
+// Points can be written a chunk at a time as long as everything goes to a
+// single file and the scale/offset doesn't depend on the data.
+bool LasWriter::streamable() const
+{
+    if (m_filename.find('#') != std::string::npos)
+        return false;
+    return !(m_xXform.m_autoOffset || m_xXform.m_autoScale ||
+        m_yXform.m_autoOffset || m_yXform.m_autoScale ||
+        m_zXform.m_autoOffset || m_zXform.m_autoScale);
+}
+
+
 void LasWriter::processOptions(const Options& options)
 {
     if (options.hasOption("a_srs"))
         setSpatialReference(options.getValueOrDefault("a_srs", std::string()));
-    m_lasHeader.setCompressed(options.getValueOrDefault("compression", false));
+    std::string compression =
+        options.getValueOrDefault<std::string>("compression", "false");
+    m_compression = LasUtils::compression(compression);
+    m_chooseCompression = (Utils::tolower(compression) == "true");
+    m_lasHeader.setCompressed(m_compression != LasCompression::None);
+    m_compressThreads = options.getValueOrDefault<size_t>("threads", 0);
+    m_writeBuffers = options.getValueOrDefault<size_t>("write_buffers", 1);
+    if (m_writeBuffers == 0)
+        throw pdal_error("Option 'write_buffers' must be greater than zero.");
+    m_dropCache = options.getValueOrDefault<bool>("drop_cache", false);
     m_discardHighReturnNumbers = options.getValueOrDefault(
         "discard_high_return_numbers", false);
     StringList extraDims = options.getValueOrDefault<StringList>("extra_dims");
     m_extraDims = LasUtils::parse(extraDims);
-
-#ifndef PDAL_HAVE_LASZIP
-    if (m_lasHeader.compressed())
-        throw pdal_error("Can't write LAZ output.  "
-            "PDAL not built with LASzip.");
-#endif // PDAL_HAVE_LASZIP
     fillForwardList(options);
     getHeaderOptions(options);
     getVlrOptions(options);
@@ -342,6 +376,9 @@ void LasWriter::prepOutput(std::ostream *outStream)
     if (m_lasHeader.versionEquals(1, 0))
         out << (uint16_t)0xCCDD;
     m_lasHeader.setPointOffset((uint32_t)m_ostream->tellp());
+    m_cacheStart = m_lasHeader.pointOffset();
+    m_cacheAdvised = m_cacheStart;
+    m_cacheEnd = m_cacheStart;
     if (m_lasHeader.compressed())
         openCompression();
 
@@ -598,8 +635,31 @@ void LasWriter::fillHeader(MetadataNode& forward)
 }
 
 
+size_t LasWriter::compressThreads() const
+{
+    return m_compressThreads ? m_compressThreads : threads();
+}
+
+
 void LasWriter::readyCompression()
 {
+#ifdef PDAL_HAVE_LAZPERF
+    // laz-perf can compress chunks in parallel, so it's preferred when
+    // threads are enabled and it supports the point format.
+    if (m_chooseCompression && compressThreads() > 1 &&
+        m_lasHeader.pointFormat() <= 3 &&
+        LazVlr(m_lasHeader.pointFormat(),
+            m_lasHeader.pointLen()).lazPerfSupported())
+        m_compression = LasCompression::LazPerf;
+#endif
+    if (m_compression == LasCompression::LazPerf)
+    {
+        // laz-perf writes the same VLR that LASzip does.
+        LazVlr vlr(m_lasHeader.pointFormat(), m_lasHeader.pointLen());
+        std::vector<uint8_t> data = vlr.data();
+        addVlr(LASZIP_USER_ID, LASZIP_RECORD_ID, "http://laszip.org", data);
+        return;
+    }
 #ifdef PDAL_HAVE_LASZIP
     m_zipPoint.reset(new ZipPoint(m_lasHeader.pointFormat(),
         m_lasHeader.pointLen()));
@@ -616,6 +676,15 @@ void LasWriter::readyCompression()
 /// \param  pointFormat - Formt of points we're writing.
 void LasWriter::openCompression()
 {
+#ifdef PDAL_HAVE_LAZPERF
+    if (m_compression == LasCompression::LazPerf)
+    {
+        LazVlr vlr(m_lasHeader.pointFormat(), m_lasHeader.pointLen());
+        m_lazZipper.reset(new LazPerfZipper(*m_ostream, vlr,
+            compressThreads()));
+        return;
+    }
+#endif
 #ifdef PDAL_HAVE_LASZIP
     if (!m_zipper->open(*m_ostream, m_zipPoint->GetZipper()))
     {
@@ -630,6 +699,169 @@ void LasWriter::openCompression()
 }
 
 
+void LasWriter::compressBlock(const char *buf, point_count_t count)
+{
+#ifdef PDAL_HAVE_LAZPERF
+    if (m_lazZipper)
+    {
+        m_lazZipper->write(buf, count);
+        return;
+    }
+#endif
+#ifdef PDAL_HAVE_LASZIP
+    size_t pointLen = m_lasHeader.pointLen();
+    for (point_count_t i = 0; i < count; i++)
+    {
+        memcpy(m_zipPoint->m_lz_point_data.data(), buf, pointLen);
+        if (!m_zipper->write(m_zipPoint->m_lz_point))
+        {
+            std::ostringstream oss;
+            const char* err = m_zipper->get_error();
+            if (err == NULL)
+                err = "(unknown error)";
+            oss << "Error writing point: " << std::string(err);
+            throw pdal_error(oss.str());
+        }
+        buf += pointLen;
+    }
+#endif
+}
+
+
+namespace
+{
+
+// Size of the buffers written by a background thread: a multiple of both
+// the point length and the page size, about four megabytes.
+size_t writeBufSize(size_t pointLen)
+{
+    const size_t PageSize = 4096;
+    const size_t TargetSize = 4 * 1024 * 1024;
+
+    size_t a = pointLen;
+    size_t b = PageSize;
+    while (b)
+    {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    size_t unit = pointLen / a * PageSize;
+    return std::max<size_t>(1, TargetSize / unit) * unit;
+}
+
+
+// Writes blocks of data, in order, on one background thread.  Filled
+// buffers are queued to the thread and returned to the free list once
+// they've been written.  An error from the write function is rethrown to
+// the caller by the next call to buffer() or finish().
+class BlockWriter
+{
+public:
+    typedef std::function<void(const char *, size_t)> WriteFunc;
+
+    BlockWriter(size_t numBufs, size_t bufSize, WriteFunc write) :
+        m_bufs(numBufs, std::vector<char>(bufSize)), m_write(write),
+        m_stop(false)
+    {
+        for (auto& buf : m_bufs)
+            m_free.push(&buf);
+        m_thread = std::thread([this](){ run(); });
+    }
+
+    ~BlockWriter()
+        { stop(); }
+
+    // Wait for a buffer that isn't being written.
+    std::vector<char>& buffer()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this](){ return m_error || !m_free.empty(); });
+        if (m_error)
+            std::rethrow_exception(m_error);
+        std::vector<char> *buf = m_free.front();
+        m_free.pop();
+        return *buf;
+    }
+
+    // Queue the first 'size' bytes of a buffer to be written.
+    void write(std::vector<char>& buf, size_t size)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_full.push(std::make_pair(&buf, size));
+        }
+        m_cv.notify_all();
+    }
+
+    // Wait for the queued buffers to be written.
+    void finish()
+    {
+        stop();
+        if (m_error)
+            std::rethrow_exception(m_error);
+    }
+
+private:
+    std::vector<std::vector<char>> m_bufs;
+    WriteFunc m_write;
+    std::queue<std::vector<char> *> m_free;
+    std::queue<std::pair<std::vector<char> *, size_t>> m_full;
+    std::exception_ptr m_error;
+    bool m_stop;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+
+    void stop()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    // Write queued buffers until stopped and the queue is empty or until
+    // a write fails.
+    void run()
+    {
+        while (true)
+        {
+            std::pair<std::vector<char> *, size_t> block;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this](){ return m_stop || !m_full.empty(); });
+                if (m_full.empty())
+                    return;
+                block = m_full.front();
+                m_full.pop();
+            }
+            try
+            {
+                m_write(block.first->data(), block.second);
+            }
+            catch (...)
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_error = std::current_exception();
+                m_cv.notify_all();
+                return;
+            }
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_free.push(block.first);
+            }
+            m_cv.notify_all();
+        }
+    }
+};
+
+} // unnamed namespace
+
+
 void LasWriter::writeView(const PointViewPtr view)
 {
     Utils::writeProgress(m_progressFd, "READYVIEW",
@@ -637,234 +869,300 @@ void LasWriter::writeView(const PointViewPtr view)
     setAutoXForm(view);
 
     size_t pointLen = m_lasHeader.pointLen();
-
-    // Make a buffer of at most a meg.
-    std::vector<char> buf(std::min((size_t)1000000, pointLen * view->size()));
-
     const PointView& viewRef(*view.get());
 
     //ABELL - Removed callback handling for now.
     point_count_t remaining = view->size();
     PointId idx = 0;
-    while (remaining)
-    {
-        point_count_t filled = fillWriteBuf(viewRef, idx, buf);
-        idx += filled;
-        remaining -= filled;
 
-#ifdef PDAL_HAVE_LASZIP
-        if (m_lasHeader.compressed())
+    // With more than one write buffer, uncompressed points are encoded
+    // into one buffer while the others are written by a background thread.
+    if (!m_lasHeader.compressed() && m_writeBuffers > 1 &&
+        pointLen * view->size() > writeBufSize(pointLen))
+    {
+        BlockWriter writer(m_writeBuffers, writeBufSize(pointLen),
+            [this](const char *buf, size_t size){ writeBlock(buf, size); });
+        while (remaining)
         {
-            char *pos = buf.data();
-            for (point_count_t i = 0; i < filled; i++)
+            std::vector<char>& buf = writer.buffer();
+            point_count_t filled = fillWriteBuf(viewRef, idx, buf);
+            idx += filled;
+            remaining -= filled;
+            writer.write(buf, filled * pointLen);
+        }
+        writer.finish();
+    }
+    else
+    {
+        // Make a buffer of at most a meg.
+        std::vector<char> buf(std::min((size_t)1000000,
+            pointLen * view->size()));
+        while (remaining)
+        {
+            point_count_t filled = fillWriteBuf(viewRef, idx, buf);
+            idx += filled;
+            remaining -= filled;
+
+            if (m_lasHeader.compressed())
             {
-                memcpy(m_zipPoint->m_lz_point_data.data(), pos, pointLen);
-                if (!m_zipper->write(m_zipPoint->m_lz_point))
-                {
-                    std::ostringstream oss;
-                    const char* err = m_zipper->get_error();
-                    if (err == NULL)
-                        err = "(unknown error)";
-                    oss << "Error writing point: " << std::string(err);
-                    throw pdal_error(oss.str());
-                }
-                pos += pointLen;
+                TraceScope trace("compress", "writers.las compress block");
+                compressBlock(buf.data(), filled);
             }
+            else
+                writeBlock(buf.data(), filled * pointLen);
         }
-        else
-            m_ostream->write(buf.data(), filled * pointLen);
-#else
-        m_ostream->write(buf.data(), filled * pointLen);
-#endif
     }
     Utils::writeProgress(m_progressFd, "DONEVIEW",
         std::to_string(view->size()));
 }
 
 
-point_count_t LasWriter::fillWriteBuf(const PointView& view,
-    PointId startId, std::vector<char>& buf)
+// Write a block of uncompressed points.  When the page cache is dropped,
+// written data is advised every DropCacheInterval bytes.  Each range is
+// advised twice: first when it's been written, which starts it being
+// written back, and again at the next advice, when it's likely to be
+// clean and can be dropped.
+void LasWriter::writeBlock(const char *buf, size_t size)
 {
-    point_count_t blocksize = buf.size() / m_lasHeader.pointLen();
-    blocksize = std::min(blocksize, view.size() - startId);
-
-    bool has14Format = m_lasHeader.has14Format();
-    bool hasColor = m_lasHeader.hasColor();
-    bool hasTime = m_lasHeader.hasTime();
-    bool hasInfrared = m_lasHeader.hasInfrared();
+    const uintmax_t DropCacheInterval = 16 * 1024 * 1024;
 
-    PointId lastId = startId + blocksize;
-    static const size_t maxReturnCount = m_lasHeader.maxReturnCount();
-    LeInserter ostream(buf.data(), buf.size());
-    for (PointId idx = startId; idx < lastId; idx++)
     {
-        // we always write the base fields
-        using namespace Dimension;
+        TraceScope trace("io", "writers.las write block");
+        m_ostream->write(buf, size);
+    }
+    if (!m_dropCache || m_curFilename.empty())
+        return;
 
-        uint8_t returnNumber(1);
-        uint8_t numberOfReturns(1);
-        if (view.hasDim(Id::ReturnNumber))
-        {
-            returnNumber = view.getFieldAs<uint8_t>(Id::ReturnNumber,
-                idx);
-            if (returnNumber < 1 || returnNumber > maxReturnCount)
-                m_error.returnNumWarning(returnNumber);
-        }
-        if (view.hasDim(Id::NumberOfReturns))
-            numberOfReturns = view.getFieldAs<uint8_t>(
-                Id::NumberOfReturns, idx);
-        if (numberOfReturns == 0)
-            m_error.numReturnsWarning(0);
-        if (numberOfReturns > maxReturnCount)
-        {
-            if (m_discardHighReturnNumbers)
-            {
-                // If this return number is too high, pitch the point.
-                if (returnNumber > maxReturnCount)
-                    continue;
-                numberOfReturns = maxReturnCount;
-            }
-            else
-                m_error.numReturnsWarning(numberOfReturns);
-        }
+    m_cacheEnd += size;
+    if (m_cacheEnd - m_cacheAdvised < DropCacheInterval)
+        return;
+    m_ostream->flush();
+    FileUtils::adviseDontNeed(m_curFilename, m_cacheStart,
+        m_cacheEnd - m_cacheStart);
+    m_cacheStart = m_cacheAdvised;
+    m_cacheAdvised = m_cacheEnd;
+}
 
-        double xOrig = view.getFieldAs<double>(Id::X, idx);
-        double yOrig = view.getFieldAs<double>(Id::Y, idx);
-        double zOrig = view.getFieldAs<double>(Id::Z, idx);
 
-        double x = (xOrig - m_xXform.m_offset) / m_xXform.m_scale;
-        double y = (yOrig - m_yXform.m_offset) / m_yXform.m_scale;
-        double z = (zOrig - m_zXform.m_offset) / m_zXform.m_scale;
+namespace
+{
 
-        auto converter = [this](double d, Dimension::Id::Enum dim) -> int32_t
-        {
-            int32_t i;
+// Fetch a field of a block of consecutive points of a view, or fill the
+// block with a default if the view doesn't have the dimension.  Values are
+// copied without conversion when the dimension has the type of the field.
+template <typename T>
+void fetchField(const PointView& view, Dimension::Id::Enum id,
+    PointId firstId, point_count_t count, T *vals, T def)
+{
+    if (!view.hasDim(id))
+        std::fill(vals, vals + count, def);
+    else if (view.dimType(id) == LasUtils::type<T>())
+        for (point_count_t i = 0; i < count; ++i)
+            view.getRawField(id, firstId + i, vals + i);
+    else
+        for (point_count_t i = 0; i < count; ++i)
+            vals[i] = view.getFieldAs<T>(id, firstId + i);
+}
 
-            if (!Utils::numericCast(d, i))
-            {
-                std::ostringstream oss;
-                oss << "Unable to convert scaled value (" << d << ") to "
-                    "int32 for dimension '" << Dimension::name(dim) <<
-                    "' when writing LAS/LAZ file " << m_curFilename << ".";
-                throw pdal_error(oss.str());
-            }
-            return i;
-        };
+// Separate loop so that the compiler can vectorize it.
+void unscaleBlock(const double *in, double *out, point_count_t count,
+    double scale, double offset)
+{
+    for (point_count_t i = 0; i < count; ++i)
+        out[i] = (in[i] - offset) / scale;
+}
+
+} // unnamed namespace
 
-        ostream << converter(x, Id::X);
-        ostream << converter(y, Id::Y);
-        ostream << converter(z, Id::Z);
 
-        uint16_t intensity = 0;
-        if (view.hasDim(Id::Intensity))
-            intensity = view.getFieldAs<uint16_t>(Id::Intensity, idx);
-        ostream << intensity;
+point_count_t LasWriter::fillWriteBuf(const PointView& view,
+    PointId startId, std::vector<char>& buf)
+{
+    switch (m_lasHeader.pointFormat())
+    {
+    case 0:
+        return fillWriteBuf<LasFormat<0>>(view, startId, buf);
+    case 1:
+        return fillWriteBuf<LasFormat<1>>(view, startId, buf);
+    case 2:
+        return fillWriteBuf<LasFormat<2>>(view, startId, buf);
+    case 3:
+        return fillWriteBuf<LasFormat<3>>(view, startId, buf);
+    case 6:
+        return fillWriteBuf<LasFormat<6>>(view, startId, buf);
+    case 7:
+        return fillWriteBuf<LasFormat<7>>(view, startId, buf);
+    case 8:
+        return fillWriteBuf<LasFormat<8>>(view, startId, buf);
+    default:
+    {
+        std::ostringstream oss;
+        oss << "Unsupported LAS point format " <<
+            (int)m_lasHeader.pointFormat() << ".";
+        throw pdal_error(oss.str());
+    }
+    }
+}
+
 
-        uint8_t scanChannel(0);
-        if (view.hasDim(Id::ScanChannel))
-            scanChannel = view.getFieldAs<uint8_t>(Id::ScanChannel, idx);
+// Points are fetched a block at a time into an array for each field, the
+// positions are scaled, and then each point is encoded.
+template <typename FORMAT>
+point_count_t LasWriter::fillWriteBuf(const PointView& view,
+    PointId startId, std::vector<char>& buf)
+{
+    using namespace Dimension;
 
-        uint8_t scanDirectionFlag(0);
-        if (view.hasDim(Id::ScanDirectionFlag))
-            scanDirectionFlag = view.getFieldAs<uint8_t>(
-                Id::ScanDirectionFlag, idx);
+    const point_count_t BlockSize = 256;
 
-        uint8_t edgeOfFlightLine(0);
-        if (view.hasDim(Id::EdgeOfFlightLine))
-            edgeOfFlightLine = view.getFieldAs<uint8_t>(
-                Id::EdgeOfFlightLine, idx);
+    point_count_t blocksize = buf.size() / m_lasHeader.pointLen();
+    blocksize = std::min(blocksize, view.size() - startId);
 
-        if (has14Format)
-        {
-            uint8_t bits = returnNumber | (numberOfReturns << 4);
-            ostream << bits;
-            bits = (scanChannel << 4) | (scanDirectionFlag << 6) |
-                (edgeOfFlightLine << 7);
-            ostream << bits;
-        }
-        else
-        {
-            uint8_t bits = returnNumber | (numberOfReturns << 3) |
-                (scanDirectionFlag << 6) | (edgeOfFlightLine << 7);
-            ostream << bits;
-        }
+    double xOrig[BlockSize], yOrig[BlockSize], zOrig[BlockSize];
+    double x[BlockSize], y[BlockSize], z[BlockSize];
+    uint16_t intensity[BlockSize];
+    uint8_t returnNum[BlockSize];
+    uint8_t numReturns[BlockSize];
+    uint8_t scanChannel[BlockSize];
+    uint8_t scanDirFlag[BlockSize];
+    uint8_t flight[BlockSize];
+    uint8_t classification[BlockSize];
+    uint8_t user[BlockSize];
+    float scanAngle[BlockSize];
+    int8_t scanAngleRank[BlockSize];
+    uint16_t pointSourceId[BlockSize];
+    double gpsTime[BlockSize];
+    uint16_t red[BlockSize], green[BlockSize], blue[BlockSize];
+    uint16_t infrared[BlockSize];
+
+    auto converter = [this](double d, Dimension::Id::Enum dim) -> int32_t
+    {
+        int32_t i;
 
-        uint8_t classification = 0;
-        if (view.hasDim(Id::Classification))
+        if (!Utils::numericCast(d, i))
         {
-            classification = view.getFieldAs<uint8_t>(Id::Classification,
-                idx);
+            std::ostringstream oss;
+            oss << "Unable to convert scaled value (" << d << ") to "
+                "int32 for dimension '" << Dimension::name(dim) <<
+                "' when writing LAS/LAZ file " << m_curFilename << ".";
+            throw pdal_error(oss.str());
         }
-        ostream << classification;
+        return i;
+    };
 
-        uint8_t userData = 0;
-        if (view.hasDim(Id::UserData))
-            userData = view.getFieldAs<uint8_t>(Id::UserData, idx);
-        if (has14Format)
+    const size_t maxReturnCount = m_lasHeader.maxReturnCount();
+    LeInserter ostream(buf.data(), buf.size());
+    PointId lastId = startId + blocksize;
+    for (PointId first = startId; first < lastId; first += BlockSize)
+    {
+        point_count_t num = std::min(lastId - first, BlockSize);
+
+        fetchField(view, Id::X, first, num, xOrig, 0.0);
+        fetchField(view, Id::Y, first, num, yOrig, 0.0);
+        fetchField(view, Id::Z, first, num, zOrig, 0.0);
+        fetchField(view, Id::Intensity, first, num, intensity, (uint16_t)0);
+        fetchField(view, Id::ReturnNumber, first, num, returnNum,
+            (uint8_t)1);
+        fetchField(view, Id::NumberOfReturns, first, num, numReturns,
+            (uint8_t)1);
+        fetchField(view, Id::ScanDirectionFlag, first, num, scanDirFlag,
+            (uint8_t)0);
+        fetchField(view, Id::EdgeOfFlightLine, first, num, flight,
+            (uint8_t)0);
+        fetchField(view, Id::Classification, first, num, classification,
+            (uint8_t)0);
+        fetchField(view, Id::UserData, first, num, user, (uint8_t)0);
+        fetchField(view, Id::PointSourceId, first, num, pointSourceId,
+            (uint16_t)0);
+        if (FORMAT::is14)
         {
-            int16_t scanAngleRank = 0;
-            if (view.hasDim(Id::ScanAngleRank))
-                scanAngleRank =
-                    view.getFieldAs<float>(Id::ScanAngleRank, idx) / .006;
-            ostream << userData << scanAngleRank;
+            fetchField(view, Id::ScanChannel, first, num, scanChannel,
+                (uint8_t)0);
+            fetchField(view, Id::ScanAngleRank, first, num, scanAngle, 0.0f);
         }
         else
+            fetchField(view, Id::ScanAngleRank, first, num, scanAngleRank,
+                (int8_t)0);
+        if (FORMAT::hasTime)
+            fetchField(view, Id::GpsTime, first, num, gpsTime, 0.0);
+        if (FORMAT::hasColor)
         {
-            int8_t scanAngleRank = 0;
-            if (view.hasDim(Id::ScanAngleRank))
-                scanAngleRank = view.getFieldAs<int8_t>(Id::ScanAngleRank, idx);
-
-            ostream << scanAngleRank << userData;
+            fetchField(view, Id::Red, first, num, red, (uint16_t)0);
+            fetchField(view, Id::Green, first, num, green, (uint16_t)0);
+            fetchField(view, Id::Blue, first, num, blue, (uint16_t)0);
         }
+        if (FORMAT::hasInfrared)
+            fetchField(view, Id::Infrared, first, num, infrared, (uint16_t)0);
 
-        uint16_t pointSourceId = 0;
-        if (view.hasDim(Id::PointSourceId))
-            pointSourceId = view.getFieldAs<uint16_t>(Id::PointSourceId,
-                idx);
-        ostream << pointSourceId;
+        unscaleBlock(xOrig, x, num, m_xXform.m_scale, m_xXform.m_offset);
+        unscaleBlock(yOrig, y, num, m_yXform.m_scale, m_yXform.m_offset);
+        unscaleBlock(zOrig, z, num, m_zXform.m_scale, m_zXform.m_offset);
 
-        if (hasTime)
+        for (point_count_t i = 0; i < num; ++i)
         {
-            double t = 0.0;
-            if (view.hasDim(Id::GpsTime))
-                t = view.getFieldAs<double>(Id::GpsTime, idx);
-            ostream << t;
-        }
+            uint8_t returnNumber = returnNum[i];
+            uint8_t numberOfReturns = numReturns[i];
 
-        if (hasColor)
-        {
-            uint16_t red = 0;
-            uint16_t green = 0;
-            uint16_t blue = 0;
-            if (view.hasDim(Id::Red))
-                red = view.getFieldAs<uint16_t>(Id::Red, idx);
-            if (view.hasDim(Id::Green))
-                green = view.getFieldAs<uint16_t>(Id::Green, idx);
-            if (view.hasDim(Id::Blue))
-                blue = view.getFieldAs<uint16_t>(Id::Blue, idx);
-
-            ostream << red << green << blue;
-        }
+            if (view.hasDim(Id::ReturnNumber) &&
+                (returnNumber < 1 || returnNumber > maxReturnCount))
+                m_error.returnNumWarning(returnNumber);
+            if (numberOfReturns == 0)
+                m_error.numReturnsWarning(0);
+            if (numberOfReturns > maxReturnCount)
+            {
+                if (m_discardHighReturnNumbers)
+                {
+                    // If this return number is too high, pitch the point.
+                    if (returnNumber > maxReturnCount)
+                        continue;
+                    numberOfReturns = maxReturnCount;
+                }
+                else
+                    m_error.numReturnsWarning(numberOfReturns);
+            }
 
-        if (hasInfrared)
-        {
-            uint16_t nearInfraRed = 0;
+            ostream << converter(x[i], Id::X);
+            ostream << converter(y[i], Id::Y);
+            ostream << converter(z[i], Id::Z);
+            ostream << intensity[i];
 
-            if (view.hasDim(Id::Infrared))
-                nearInfraRed = view.getFieldAs<uint16_t>(Id::Infrared, idx);
-            ostream << nearInfraRed;
-        }
+            if (FORMAT::is14)
+            {
+                uint8_t bits = returnNumber | (numberOfReturns << 4);
+                ostream << bits;
+                bits = (scanChannel[i] << 4) | (scanDirFlag[i] << 6) |
+                    (flight[i] << 7);
+                ostream << bits;
+                int16_t angle = scanAngle[i] / .006;
+                ostream << classification[i] << user[i] << angle;
+            }
+            else
+            {
+                uint8_t bits = returnNumber | (numberOfReturns << 3) |
+                    (scanDirFlag[i] << 6) | (flight[i] << 7);
+                ostream << bits << classification[i] << scanAngleRank[i] <<
+                    user[i];
+            }
+            ostream << pointSourceId[i];
 
-        Everything e;
-        for (auto& dim : m_extraDims)
-        {
-            view.getField((char *)&e, dim.m_dimType.m_id,
-                dim.m_dimType.m_type, idx);
-            ostream.put(dim.m_dimType.m_type, e);
-        }
+            if (FORMAT::hasTime)
+                ostream << gpsTime[i];
+            if (FORMAT::hasColor)
+                ostream << red[i] << green[i] << blue[i];
+            if (FORMAT::hasInfrared)
+                ostream << infrared[i];
 
-        using namespace Dimension;
-        m_summaryData->addPoint(xOrig, yOrig, zOrig, returnNumber);
+            Everything e;
+            for (auto& dim : m_extraDims)
+            {
+                view.getField((char *)&e, dim.m_dimType.m_id,
+                    dim.m_dimType.m_type, first + i);
+                ostream.put(dim.m_dimType.m_type, e);
+            }
+
+            m_summaryData->addPoint(xOrig[i], yOrig[i], zOrig[i],
+                returnNumber);
+        }
     }
     return blocksize;
 }
@@ -885,10 +1183,18 @@ void LasWriter::finishOutput()
     //ABELL - The zipper has to be closed right after all the points
     // are written or bad things happen since this call expects the
     // stream to be positioned at a particular position.
-#ifdef PDAL_HAVE_LASZIP
     if (m_lasHeader.compressed())
-        m_zipper->close();
+    {
+        TraceScope trace("compress", "writers.las compressor flush");
+#ifdef PDAL_HAVE_LAZPERF
+        if (m_lazZipper)
+            m_lazZipper->close();
 #endif
+#ifdef PDAL_HAVE_LASZIP
+        if (m_zipper)
+            m_zipper->close();
+#endif
+    }
 
     log()->get(LogLevel::Debug) << "Wrote " <<
         m_summaryData->getTotalNumPoints() <<
@@ -917,13 +1223,12 @@ void LasWriter::finishOutput()
     out << m_lasHeader;
     out.seek(m_lasHeader.pointOffset());
 
-#ifdef PDAL_HAVE_LASZIP
     if (m_lasHeader.compressed())
     {
         m_zipper.reset();
         m_zipPoint.reset();
+        m_lazZipper.reset();
     }
-#endif
     m_ostream->flush();
 }
 
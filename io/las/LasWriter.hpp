@@ -41,6 +41,7 @@
 #include "LasHeader.hpp"
 #include "LasUtils.hpp"
 #include "SummaryData.hpp"
+#include "LazPerf.hpp"
 #include "ZipPoint.hpp"
 
 extern "C" int32_t LasWriter_ExitFunc();
@@ -73,6 +74,7 @@ public:
     LasWriter();
 
     Options getDefaultOptions();
+    virtual bool streamable() const;
 
 protected:
     void prepOutput(std::ostream *out);
@@ -84,6 +86,26 @@ private:
     std::unique_ptr<SummaryData> m_summaryData;
     std::unique_ptr<LASzipper> m_zipper;
     std::unique_ptr<ZipPoint> m_zipPoint;
+    std::unique_ptr<LazPerfZipper> m_lazZipper;
+    LasCompression::Enum m_compression;
+    // Whether compression was just turned on, so either library may be
+    // used.
+    bool m_chooseCompression;
+    // Number of threads used to compress points.  Zero means use the
+    // stage's thread count.
+    size_t m_compressThreads;
+    // Number of buffers of uncompressed point data.  With more than one,
+    // points are encoded into one buffer while others are written by a
+    // background thread.
+    size_t m_writeBuffers;
+    // Whether written point data is dropped from the page cache.
+    // m_cacheStart is the start of the data that may still be cached,
+    // m_cacheAdvised the end of the data last advised and m_cacheEnd the
+    // end of the data written.
+    bool m_dropCache;
+    uintmax_t m_cacheStart;
+    uintmax_t m_cacheAdvised;
+    uintmax_t m_cacheEnd;
     bool m_discardHighReturnNumbers;
     std::map<std::string, std::string> m_headerVals;
     std::vector<VlrOptionInfo> m_optionInfos;
@@ -133,6 +155,9 @@ private:
         const MetadataNode& base);
     void handleForwards(MetadataNode& forward);
     void fillHeader(MetadataNode& forward);
+    point_count_t fillWriteBuf(const PointView& view, PointId startId,
+        std::vector<char>& buf);
+    template <typename FORMAT>
     point_count_t fillWriteBuf(const PointView& view, PointId startId,
         std::vector<char>& buf);
     void setVlrsFromMetadata(MetadataNode& forward);
@@ -142,6 +167,9 @@ private:
     void setVlrsFromSpatialRef();
     void readyCompression();
     void openCompression();
+    void compressBlock(const char *buf, point_count_t count);
+    void writeBlock(const char *buf, size_t size);
+    size_t compressThreads() const;
     void addVlr(const std::string& userId, uint16_t recordId,
         const std::string& description, std::vector<uint8_t>& data);
     bool addGeotiffVlr(GeotiffSupport& geotiff, uint16_t recordId,
@@ -0,0 +1,654 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "LazPerf.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <limits>
+#include <sstream>
+
+#include <pdal/Compression.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <pdal/util/Extractor.hpp>
+#include <pdal/util/Inserter.hpp>
+#include <pdal/util/IStream.hpp>
+#include <pdal/util/OStream.hpp>
+
+namespace pdal
+{
+
+namespace
+{
+
+// Size of the VLR data before the items.
+const size_t VlrHeaderSize = 34;
+const size_t VlrItemSize = 6;
+
+} // unnamed namespace
+
+
+LazVlr::LazVlr(uint8_t format, uint16_t pointLen, uint32_t chunkSize) :
+    m_compressor(PointwiseChunked), m_coder(0), m_versionMajor(2),
+    m_versionMinor(2), m_versionRevision(0), m_options(0),
+    m_chunkSize(chunkSize), m_numSpecialEvlrs(-1), m_offsetSpecialEvlrs(-1)
+{
+    if (format > 3)
+    {
+        std::ostringstream oss;
+        oss << "LAZ compression of point format " << (int)format <<
+            " isn't supported.";
+        throw pdal_error(oss.str());
+    }
+
+    m_items.push_back(Item(Point10, 20, 2));
+    if (format == 1 || format == 3)
+        m_items.push_back(Item(GpsTime11, 8, 2));
+    if (format == 2 || format == 3)
+        m_items.push_back(Item(Rgb12, 6, 2));
+    size_t len = this->pointLen();
+    if (pointLen > len)
+        m_items.push_back(Item(Byte, (uint16_t)(pointLen - len), 2));
+}
+
+
+LazVlr::LazVlr(const char *data, size_t size)
+{
+    LeExtractor in(data, size);
+
+    uint16_t numItems = 0;
+    if (size >= VlrHeaderSize)
+    {
+        in >> m_compressor >> m_coder >> m_versionMajor >> m_versionMinor >>
+            m_versionRevision >> m_options >> m_chunkSize >>
+            m_numSpecialEvlrs >> m_offsetSpecialEvlrs >> numItems;
+    }
+    if (size < VlrHeaderSize || size < VlrHeaderSize + numItems * VlrItemSize)
+        throw pdal_error("Invalid LASzip VLR.");
+    for (uint16_t i = 0; i < numItems; ++i)
+    {
+        uint16_t type, size, version;
+        in >> type >> size >> version;
+        m_items.push_back(Item(type, size, version));
+    }
+}
+
+
+std::vector<uint8_t> LazVlr::data() const
+{
+    std::vector<uint8_t> data(VlrHeaderSize + m_items.size() * VlrItemSize);
+    LeInserter out(data.data(), data.size());
+
+    out << m_compressor << m_coder << m_versionMajor << m_versionMinor <<
+        m_versionRevision << m_options << m_chunkSize << m_numSpecialEvlrs <<
+        m_offsetSpecialEvlrs << (uint16_t)m_items.size();
+    for (auto& item : m_items)
+        out << item.m_type << item.m_size << item.m_version;
+    return data;
+}
+
+
+bool LazVlr::lazPerfSupported() const
+{
+    for (auto& item : m_items)
+        if (item.m_version != 2 || (item.m_type != Point10 &&
+            item.m_type != GpsTime11 && item.m_type != Rgb12))
+            return false;
+    return true;
+}
+
+
+size_t LazVlr::pointLen() const
+{
+    size_t len = 0;
+    for (auto& item : m_items)
+        len += item.m_size;
+    return len;
+}
+
+#ifdef PDAL_HAVE_LAZPERF
+
+namespace
+{
+
+// Byte access to a standard input stream for laz-perf.
+class IStreamAdapter
+{
+public:
+    IStreamAdapter(std::istream& in) : m_in(in)
+    {}
+
+    unsigned char getByte()
+        { return (unsigned char)m_in.get(); }
+    void getBytes(unsigned char *b, int len)
+        { m_in.read((char *)b, len); }
+
+private:
+    std::istream& m_in;
+};
+
+
+// Byte access to a standard output stream for laz-perf.
+class OStreamAdapter
+{
+public:
+    OStreamAdapter(std::ostream& out) : m_out(out)
+    {}
+
+    void putByte(const unsigned char b)
+        { m_out.put((char)b); }
+    void putBytes(const unsigned char *b, size_t len)
+        { m_out.write((const char *)b, len); }
+
+private:
+    std::ostream& m_out;
+};
+
+
+// Byte access to compressed data in memory.  The decoder may read a few
+// bytes past the end of the data, so zeros are returned there.
+class MemoryAdapter
+{
+public:
+    MemoryAdapter(const char *data, size_t size) : m_data(data),
+        m_size(size), m_pos(0)
+    {}
+
+    unsigned char getByte()
+        { return m_pos < m_size ? (unsigned char)m_data[m_pos++] : 0; }
+    void getBytes(unsigned char *b, int len)
+    {
+        for (int i = 0; i < len; ++i)
+            b[i] = getByte();
+    }
+
+private:
+    const char *m_data;
+    size_t m_size;
+    size_t m_pos;
+};
+
+
+// Add the laz-perf fields that match the items of a LASzip VLR.
+template<typename LasZipEngine>
+void addLasFields(LasZipEngine& engine, const LazVlr& vlr)
+{
+    for (auto& item : vlr.items())
+    {
+        bool ok = (item.m_version == 2);
+        if (ok && item.m_type == LazVlr::Point10)
+            engine->template add_field<laszip::formats::las::point10>();
+        else if (ok && item.m_type == LazVlr::GpsTime11)
+            engine->template add_field<laszip::formats::las::gpstime>();
+        else if (ok && item.m_type == LazVlr::Rgb12)
+            engine->template add_field<laszip::formats::las::rgb>();
+        else
+        {
+            std::ostringstream oss;
+            oss << "laz-perf can't compress or decompress LASzip item " <<
+                item.m_type << " version " << item.m_version << ".  Use "
+                "LASzip instead.";
+            throw pdal_error(oss.str());
+        }
+    }
+}
+
+
+// The arithmetic decoder and decompressor for a run of points that are
+// compressed together: a chunk, or all the points of an unchunked file.
+template<typename InputStream>
+class LasDecoder
+{
+public:
+    LasDecoder(InputStream& in, const LazVlr& vlr) : m_decoder(in),
+        m_decompressor(laszip::formats::make_dynamic_decompressor(m_decoder))
+    { addLasFields(m_decompressor, vlr); }
+
+    void decompress(char *buf)
+        { m_decompressor->decompress(buf); }
+
+private:
+    typedef laszip::decoders::arithmetic<InputStream> Decoder;
+    Decoder m_decoder;
+    typedef typename laszip::formats::dynamic_field_decompressor<Decoder>::ptr
+        Decompressor;
+    Decompressor m_decompressor;
+};
+
+
+// The arithmetic encoder and compressor for a chunk of points.
+template<typename OutputStream>
+class LasEncoder
+{
+public:
+    LasEncoder(OutputStream& out, const LazVlr& vlr) : m_encoder(out),
+        m_compressor(laszip::formats::make_dynamic_compressor(m_encoder))
+    { addLasFields(m_compressor, vlr); }
+
+    void compress(const char *buf)
+        { m_compressor->compress(buf); }
+    void done()
+        { m_encoder.done(); }
+
+private:
+    typedef laszip::encoders::arithmetic<OutputStream> Encoder;
+    Encoder m_encoder;
+    typedef typename laszip::formats::dynamic_field_compressor<Encoder>::ptr
+        Compressor;
+    Compressor m_compressor;
+};
+
+} // unnamed namespace
+
+
+struct LazPerfUnzipper::Impl
+{
+    Impl(std::istream& in, const LazVlr& vlr) : m_in(in), m_adapter(in),
+        m_vlr(vlr), m_pointLen(vlr.pointLen()), m_chunk(0), m_chunkLeft(0)
+    {}
+
+    std::istream& m_in;
+    IStreamAdapter m_adapter;
+    LazVlr m_vlr;
+    size_t m_pointLen;
+
+    // Unchunked data is decompressed straight from the stream.
+    std::unique_ptr<LasDecoder<IStreamAdapter>> m_streamDecoder;
+
+    // Chunked data is read into memory a chunk at a time.
+    std::vector<Chunk> m_chunks;
+    size_t m_chunk;
+    point_count_t m_chunkLeft;
+    std::vector<char> m_chunkData;
+    std::unique_ptr<MemoryAdapter> m_chunkBuf;
+    std::unique_ptr<LasDecoder<MemoryAdapter>> m_chunkDecoder;
+
+    void readChunkTable(uint64_t pointOffset);
+    void nextChunk();
+};
+
+
+LazPerfUnzipper::LazPerfUnzipper(std::istream& in, const LazVlr& vlr,
+    uint64_t pointOffset) : m_impl(new Impl(in, vlr))
+{
+    if (vlr.compressor() == LazVlr::PointwiseChunked)
+    {
+        if (vlr.chunkSize() == (std::numeric_limits<uint32_t>::max)())
+            throw pdal_error("laz-perf can't decompress LAZ data with "
+                "variable chunk sizes.  Use LASzip instead.");
+        m_impl->readChunkTable(pointOffset);
+    }
+    else if (vlr.compressor() == LazVlr::Pointwise)
+    {
+        in.seekg(pointOffset);
+        m_impl->m_streamDecoder.reset(
+            new LasDecoder<IStreamAdapter>(m_impl->m_adapter, vlr));
+    }
+    else
+    {
+        std::ostringstream oss;
+        oss << "Invalid LASzip compressor type " << vlr.compressor() << ".";
+        throw pdal_error(oss.str());
+    }
+}
+
+
+LazPerfUnzipper::~LazPerfUnzipper()
+{}
+
+
+// The points of chunked data are preceded by the offset of the chunk
+// table, which holds the compressed size of each chunk.
+void LazPerfUnzipper::Impl::readChunkTable(uint64_t pointOffset)
+{
+    ILeStream in(&m_in);
+
+    in.seek(pointOffset);
+    int64_t tableOffset;
+    in >> tableOffset;
+    uint64_t chunkOffset = pointOffset + sizeof(tableOffset);
+
+    // Writers that can't seek store the table offset at the end of the
+    // file instead.
+    if (tableOffset == -1)
+    {
+        m_in.seekg(-(std::streamoff)sizeof(tableOffset), std::ios::end);
+        in >> tableOffset;
+    }
+    if (!m_in.good() || tableOffset < (int64_t)chunkOffset)
+        throw pdal_error("Invalid LAZ chunk table offset.");
+
+    in.seek(tableOffset);
+    uint32_t version;
+    uint32_t numChunks;
+    in >> version >> numChunks;
+    if (!m_in.good() || version != 0)
+        throw pdal_error("Invalid LAZ chunk table.");
+
+    laszip::decoders::arithmetic<IStreamAdapter> decoder(m_adapter);
+    decoder.readInitBytes();
+    laszip::decompressors::integer decompressor(32, 2);
+    decompressor.init();
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < numChunks; ++i)
+    {
+        size = (uint32_t)decompressor.decompress(decoder, size, 1);
+        m_chunks.push_back(Chunk(chunkOffset, size));
+        chunkOffset += size;
+    }
+}
+
+
+void LazPerfUnzipper::Impl::nextChunk()
+{
+    if (m_chunk >= m_chunks.size())
+        throw pdal_error("Attempt to read past the last LAZ chunk.");
+
+    const Chunk& chunk = m_chunks[m_chunk++];
+    m_chunkData.resize(chunk.m_size);
+    m_in.seekg(chunk.m_offset);
+    m_in.read(m_chunkData.data(), chunk.m_size);
+    if (m_in.gcount() != (std::streamsize)chunk.m_size)
+        throw pdal_error("Unable to read LAZ chunk.");
+
+    m_chunkDecoder.reset();
+    m_chunkBuf.reset(new MemoryAdapter(m_chunkData.data(), chunk.m_size));
+    m_chunkDecoder.reset(new LasDecoder<MemoryAdapter>(*m_chunkBuf, m_vlr));
+    m_chunkLeft = m_vlr.chunkSize();
+}
+
+
+void LazPerfUnzipper::read(char *buf, point_count_t count)
+{
+    Impl& d = *m_impl;
+
+    if (d.m_streamDecoder)
+    {
+        for (point_count_t i = 0; i < count; ++i, buf += d.m_pointLen)
+            d.m_streamDecoder->decompress(buf);
+        return;
+    }
+    while (count)
+    {
+        if (d.m_chunkLeft == 0)
+            d.nextChunk();
+        point_count_t num = (std::min)(count, d.m_chunkLeft);
+        for (point_count_t i = 0; i < num; ++i, buf += d.m_pointLen)
+            d.m_chunkDecoder->decompress(buf);
+        d.m_chunkLeft -= num;
+        count -= num;
+    }
+}
+
+
+const LazVlr& LazPerfUnzipper::vlr() const
+{
+    return m_impl->m_vlr;
+}
+
+
+const std::vector<LazPerfUnzipper::Chunk>& LazPerfUnzipper::chunks() const
+{
+    return m_impl->m_chunks;
+}
+
+
+void LazPerfUnzipper::seekChunk(size_t chunk)
+{
+    m_impl->m_chunk = chunk;
+    m_impl->m_chunkLeft = 0;
+    m_impl->m_chunkDecoder.reset();
+}
+
+
+// The points of a chunk can only be decompressed in order, so the points
+// before 'point' in its chunk are decompressed and discarded.
+void LazPerfUnzipper::seek(point_count_t point)
+{
+    if (m_impl->m_chunks.empty())
+        throw pdal_error("Can't seek in LAZ data that isn't chunked.");
+
+    uint32_t chunkSize = m_impl->m_vlr.chunkSize();
+    seekChunk(point / chunkSize);
+    point_count_t skip = point % chunkSize;
+    if (skip)
+    {
+        std::vector<char> buf(skip * m_impl->m_pointLen);
+        read(buf.data(), skip);
+    }
+}
+
+
+// Chunks are compressed independently, so they can be decompressed by
+// separate threads.
+void LazPerfUnzipper::decompressChunk(const LazVlr& vlr, const char *data,
+    size_t size, char *buf, point_count_t count)
+{
+    MemoryAdapter in(data, size);
+    LasDecoder<MemoryAdapter> decoder(in, vlr);
+    size_t ptLen = vlr.pointLen();
+    for (point_count_t i = 0; i < count; ++i, buf += ptLen)
+        decoder.decompress(buf);
+}
+
+
+struct LazPerfZipper::Impl
+{
+    Impl(std::ostream& out, const LazVlr& vlr, size_t threads) :
+        m_out(out), m_adapter(out), m_vlr(vlr), m_pointLen(vlr.pointLen()),
+        m_chunkPoints(0), m_threads(threads)
+    {
+        if (m_threads > 1)
+            m_pool.reset(new ThreadPool(m_threads));
+    }
+
+    std::ostream& m_out;
+    OStreamAdapter m_adapter;
+    LazVlr m_vlr;
+    size_t m_pointLen;
+    std::unique_ptr<LasEncoder<OStreamAdapter>> m_encoder;
+    point_count_t m_chunkPoints;
+    std::streampos m_tableOffsetPos;
+    std::streampos m_chunkStart;
+    std::vector<uint32_t> m_chunkSizes;
+    // With more than one thread, points are collected until there's a
+    // chunk for each thread.
+    size_t m_threads;
+    std::vector<char> m_pending;
+    // Threads that compress the pending chunks, kept for the life of the
+    // zipper.  Declared last so that the threads are joined before the
+    // data they use is destroyed.
+    std::unique_ptr<ThreadPool> m_pool;
+
+    void endChunk();
+    void writePending();
+};
+
+
+LazPerfZipper::LazPerfZipper(std::ostream& out, const LazVlr& vlr,
+        size_t threads) : m_impl(new Impl(out, vlr, threads))
+{
+    // Check the items before anything is written.
+    std::vector<unsigned char> scratch;
+    LazPerfBuf buf(scratch);
+    LasEncoder<LazPerfBuf> check(buf, vlr);
+
+    // The offset of the chunk table is filled in when it's written.
+    OLeStream ostream(&out);
+    m_impl->m_tableOffsetPos = out.tellp();
+    ostream << (int64_t)-1;
+    m_impl->m_chunkStart = out.tellp();
+}
+
+
+LazPerfZipper::~LazPerfZipper()
+{}
+
+
+void LazPerfZipper::Impl::endChunk()
+{
+    m_encoder->done();
+    m_encoder.reset();
+    std::streampos pos = m_out.tellp();
+    m_chunkSizes.push_back((uint32_t)(pos - m_chunkStart));
+    m_chunkStart = pos;
+    m_chunkPoints = 0;
+}
+
+
+// Compress the chunks of the pending points on the thread pool and
+// write them in order.
+void LazPerfZipper::Impl::writePending()
+{
+    typedef std::packaged_task<std::vector<unsigned char>()> Task;
+
+    size_t chunkLen = m_vlr.chunkSize() * m_pointLen;
+
+    std::vector<std::future<std::vector<unsigned char>>> futures;
+    for (size_t pos = 0; pos < m_pending.size(); pos += chunkLen)
+    {
+        size_t len = (std::min)(chunkLen, m_pending.size() - pos);
+        auto task = std::make_shared<Task>(std::bind(
+            &LazPerfZipper::compressChunk, std::cref(m_vlr),
+            m_pending.data() + pos, len / m_pointLen));
+        futures.push_back(task->get_future());
+        m_pool->add([task](){ (*task)(); });
+    }
+
+    // Wait for every thread before reporting the first error.
+    std::exception_ptr error;
+    for (auto& f : futures)
+    {
+        try
+        {
+            std::vector<unsigned char> data = f.get();
+            if (!error)
+            {
+                m_out.write((const char *)data.data(), data.size());
+                m_chunkSizes.push_back((uint32_t)data.size());
+            }
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+    m_pending.clear();
+}
+
+
+// Chunks are compressed independently, so they can be compressed by
+// separate threads.
+std::vector<unsigned char> LazPerfZipper::compressChunk(const LazVlr& vlr,
+    const char *buf, point_count_t count)
+{
+    std::vector<unsigned char> data;
+    LazPerfBuf out(data);
+    LasEncoder<LazPerfBuf> encoder(out, vlr);
+    size_t ptLen = vlr.pointLen();
+    for (point_count_t i = 0; i < count; ++i, buf += ptLen)
+        encoder.compress(buf);
+    encoder.done();
+    return data;
+}
+
+
+void LazPerfZipper::write(const char *buf, point_count_t count)
+{
+    Impl& d = *m_impl;
+
+    if (d.m_threads > 1)
+    {
+        size_t batchLen = d.m_threads * d.m_vlr.chunkSize() * d.m_pointLen;
+        size_t len = count * d.m_pointLen;
+        while (len)
+        {
+            size_t num = (std::min)(len, batchLen - d.m_pending.size());
+            d.m_pending.insert(d.m_pending.end(), buf, buf + num);
+            buf += num;
+            len -= num;
+            if (d.m_pending.size() == batchLen)
+                d.writePending();
+        }
+        return;
+    }
+
+    for (point_count_t i = 0; i < count; ++i, buf += d.m_pointLen)
+    {
+        if (!d.m_encoder)
+            d.m_encoder.reset(
+                new LasEncoder<OStreamAdapter>(d.m_adapter, d.m_vlr));
+        d.m_encoder->compress(buf);
+        if (++d.m_chunkPoints == d.m_vlr.chunkSize())
+            d.endChunk();
+    }
+}
+
+
+// The chunk table is a version and count followed by the compressed size
+// of each chunk, encoded as LASzip does.
+void LazPerfZipper::close()
+{
+    Impl& d = *m_impl;
+
+    if (d.m_encoder)
+        d.endChunk();
+    if (d.m_pending.size())
+        d.writePending();
+
+    OLeStream out(&d.m_out);
+    int64_t tableOffset = (int64_t)d.m_out.tellp();
+    out << (uint32_t)0 << (uint32_t)d.m_chunkSizes.size();
+
+    laszip::encoders::arithmetic<OStreamAdapter> encoder(d.m_adapter);
+    laszip::compressors::integer compressor(32, 2);
+    compressor.init();
+    for (size_t i = 0; i < d.m_chunkSizes.size(); ++i)
+        compressor.compress(encoder, i ? d.m_chunkSizes[i - 1] : 0,
+            d.m_chunkSizes[i], 1);
+    encoder.done();
+
+    std::streampos end = d.m_out.tellp();
+    out.seek(d.m_tableOffsetPos);
+    out << tableOffset;
+    out.seek(end);
+}
+
+#endif // PDAL_HAVE_LAZPERF
+
+} // namespace pdal
@@ -0,0 +1,181 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_internal.hpp>
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace pdal
+{
+
+// Contents of the LASzip VLR, which describes how the points of a LAZ file
+// are compressed.
+class PDAL_DLL LazVlr
+{
+public:
+    enum ItemType
+    {
+        Byte = 0,
+        Point10 = 6,
+        GpsTime11 = 7,
+        Rgb12 = 8
+    };
+
+    enum CompressorType
+    {
+        Pointwise = 1,
+        PointwiseChunked = 2
+    };
+
+    struct Item
+    {
+        Item(uint16_t type, uint16_t size, uint16_t version) :
+            m_type(type), m_size(size), m_version(version)
+        {}
+
+        uint16_t m_type;
+        uint16_t m_size;
+        uint16_t m_version;
+    };
+
+    // Describe chunked compression of points with a format and length.
+    LazVlr(uint8_t format, uint16_t pointLen, uint32_t chunkSize = 50000);
+    // Read the VLR from its data.
+    LazVlr(const char *data, size_t size);
+
+    std::vector<uint8_t> data() const;
+    uint16_t compressor() const
+        { return m_compressor; }
+    uint32_t chunkSize() const
+        { return m_chunkSize; }
+    const std::vector<Item>& items() const
+        { return m_items; }
+    // Length of a point described by the items.
+    size_t pointLen() const;
+    // Whether laz-perf can compress and decompress the items.
+    bool lazPerfSupported() const;
+
+private:
+    uint16_t m_compressor;
+    uint16_t m_coder;
+    uint8_t m_versionMajor;
+    uint8_t m_versionMinor;
+    uint16_t m_versionRevision;
+    uint32_t m_options;
+    uint32_t m_chunkSize;
+    int64_t m_numSpecialEvlrs;
+    int64_t m_offsetSpecialEvlrs;
+    std::vector<Item> m_items;
+};
+
+#ifdef PDAL_HAVE_LAZPERF
+
+// Decompresses LAZ points with laz-perf.  Only LASzip's version 2
+// compression of point formats 0 - 3 without extra bytes is supported.
+class PDAL_DLL LazPerfUnzipper
+{
+public:
+    // Location of the compressed data of a chunk in the input.
+    struct Chunk
+    {
+        Chunk(uint64_t offset, uint32_t size) : m_offset(offset),
+            m_size(size)
+        {}
+
+        uint64_t m_offset;
+        uint32_t m_size;
+    };
+
+    // The points of the LAZ data start at 'pointOffset' in 'in'.
+    LazPerfUnzipper(std::istream& in, const LazVlr& vlr,
+        uint64_t pointOffset);
+    ~LazPerfUnzipper();
+
+    // Decompress the next 'count' points into 'buf'.
+    void read(char *buf, point_count_t count);
+    const LazVlr& vlr() const;
+    // Chunks of chunked data, in order.  Empty if the data isn't chunked.
+    const std::vector<Chunk>& chunks() const;
+    // Continue reading at the first point of chunk 'chunk'.
+    void seekChunk(size_t chunk);
+    // Continue reading at point 'point'.  Only chunked data can be read
+    // out of order.
+    void seek(point_count_t point);
+    // Decompress the 'count' points of a chunk whose compressed data is
+    // at 'data'.
+    static void decompressChunk(const LazVlr& vlr, const char *data,
+        size_t size, char *buf, point_count_t count);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// Compresses LAZ points with laz-perf, in chunks readable by LASzip.
+class PDAL_DLL LazPerfZipper
+{
+public:
+    // Points are written to 'out' starting at its current position.  With
+    // more than one thread, a chunk for each thread is collected and the
+    // chunks are compressed in parallel.
+    LazPerfZipper(std::ostream& out, const LazVlr& vlr, size_t threads = 1);
+    ~LazPerfZipper();
+
+    // Compress 'count' points from 'buf'.
+    void write(const char *buf, point_count_t count);
+    // Finish the last chunk and write the chunk table.  Must be called
+    // after the last point is written.
+    void close();
+    // Compress the 'count' points of a chunk at 'buf'.
+    static std::vector<unsigned char> compressChunk(const LazVlr& vlr,
+        const char *buf, point_count_t count);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+#else // PDAL_HAVE_LAZPERF
+// The types here just need to be something suitable for a smart pointer.
+// They aren't ever used beyond testing for NULL.
+typedef char LazPerfUnzipper;
+typedef char LazPerfZipper;
+#endif
+
+} // namespace pdal
@@ -50,6 +50,10 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
+    virtual bool usedDimensions(StringList& /*dims*/) const
+        { return true; }
 private:
     virtual void write(const PointViewPtr /*view*/)
         {}
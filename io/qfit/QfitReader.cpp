@@ -196,6 +196,7 @@ QfitReader::QfitReader()
     , m_size(0)
     , m_littleEndian(false)
     , m_istream()
+    , m_stride(1)
 {}
 
 
@@ -282,6 +283,7 @@ Options QfitReader::getDefaultOptions()
     options.add(flip_coordinates);
     options.add(convert_z_units);
     options.add(little_endian);
+    options.add("stride", 1, "Only read every Nth point of the file.");
     return options;
 }
 
@@ -290,6 +292,9 @@ void QfitReader::processOptions(const Options& ops)
 {
     m_flip_x = ops.getValueOrDefault("flip_coordinates", true);
     m_scale_z = ops.getValueOrDefault("scale_z", 0.001);
+    m_stride = ops.getValueOrDefault<point_count_t>("stride", 1);
+    if (m_stride == 0)
+        throw pdal_error("Option 'stride' must be greater than zero.");
 }
 
 
@@ -354,11 +359,11 @@ point_count_t QfitReader::read(PointViewPtr data, point_count_t count)
         throw pdal_error("QFIT file stream is eof!");
     }
 
-    count = std::min(m_numPoints - m_index, count);
     std::vector<char> buf(m_size);
     PointId nextId = data->size();
+    PointId idx = m_index;
     point_count_t numRead = 0;
-    while (count--)
+    while (numRead < count && idx < m_numPoints)
     {
         m_istream->get(buf);
         SwitchableExtractor extractor(buf.data(), m_size, m_littleEndian);
@@ -418,10 +423,14 @@ point_count_t QfitReader::read(PointViewPtr data, point_count_t count)
         if (m_cb)
             m_cb(*data, nextId);
 
+        // Skip the points between those read.
+        idx += m_stride;
+        if (m_stride > 1 && idx < m_numPoints)
+            m_istream->skip((m_stride - 1) * m_size);
         numRead++;
         nextId++;
     }
-    m_index += numRead;
+    m_index = idx;
 
     return numRead;
 }
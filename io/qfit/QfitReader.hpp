@@ -103,6 +103,8 @@ private:
     point_count_t m_numPoints;
     std::unique_ptr<IStream> m_istream;
     point_count_t m_index;
+    // Only every m_stride'th point of the file is read.
+    point_count_t m_stride;
 
     virtual void processOptions(const Options& ops);
     virtual void initialize();
@@ -49,10 +49,19 @@ std::string SbetReader::getName() const { return s_info.name; }
 Options SbetReader::getDefaultOptions()
 {
     Options options;
+    options.add("stride", 1, "Only read every Nth point of the file.");
     return options;
 }
 
 
+void SbetReader::processOptions(const Options& options)
+{
+    m_stride = options.getValueOrDefault<point_count_t>("stride", 1);
+    if (m_stride == 0)
+        throw pdal_error("Option 'stride' must be greater than zero.");
+}
+
+
 void SbetReader::addDimensions(PointLayoutPtr layout)
 {
     layout->registerDims(getDefaultDimensions());
@@ -91,7 +100,10 @@ point_count_t SbetReader::read(PointViewPtr view, point_count_t count)
         if (m_cb)
             m_cb(*view, nextId);
 
-        idx++;
+        // Skip the points between those read.
+        idx += m_stride;
+        if (m_stride > 1 && idx < m_numPts)
+            m_stream->skip((m_stride - 1) * sizeof(double) * dims.size());
         nextId++;
         numRead++;
     }
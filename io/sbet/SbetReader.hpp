@@ -49,7 +49,7 @@ namespace pdal
 class PDAL_DLL SbetReader : public pdal::Reader
 {
 public:
-    SbetReader() : Reader()
+    SbetReader() : Reader(), m_stride(1)
         {}
 
     static void * create();
@@ -65,7 +65,10 @@ private:
     // Number of points in the file.
     point_count_t m_numPts;
     point_count_t m_index;
+    // Only every m_stride'th point of the file is read.
+    point_count_t m_stride;
 
+    virtual void processOptions(const Options& options);
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void ready(PointTableRef table);
     virtual point_count_t read(PointViewPtr view, point_count_t count);
@@ -51,6 +51,22 @@ CREATE_STATIC_PLUGIN(1, 0, TerrasolidReader, Reader, s_info)
 
 std::string TerrasolidReader::getName() const { return s_info.name; }
 
+Options TerrasolidReader::getDefaultOptions()
+{
+    Options options;
+    options.add("stride", 1, "Only read every Nth point of the file.");
+    return options;
+}
+
+
+void TerrasolidReader::processOptions(const Options& options)
+{
+    m_stride = options.getValueOrDefault<point_count_t>("stride", 1);
+    if (m_stride == 0)
+        throw pdal_error("Option 'stride' must be greater than zero.");
+}
+
+
 void TerrasolidReader::initialize()
 {
     ILeStream stream(m_filename);
@@ -167,11 +183,7 @@ void TerrasolidReader::ready(PointTableRef)
 
 point_count_t TerrasolidReader::read(PointViewPtr view, point_count_t count)
 {
-    count = std::min(count, getNumPoints() - m_index);
-
-    std::vector<char> buf(m_size * count);
-    m_istream->get(buf);
-    LeExtractor extractor(buf.data(), buf.size());
+    std::vector<char> buf(m_size);
 
     // See https://www.terrasolid.com/download/tscan.pdf
     // This spec is awful, but it's something.
@@ -181,8 +193,12 @@ point_count_t TerrasolidReader::read(PointViewPtr view, point_count_t count)
     // Also modified the fetch of time/color based on header flag (rather
     // than just not write the data into the buffer).
     PointId nextId = view->size();
-    while (!eof())
+    point_count_t numRead = 0;
+    while (numRead < count && !eof())
     {
+        m_istream->get(buf);
+        LeExtractor extractor(buf.data(), buf.size());
+
         if (m_format == TERRASOLID_Format_1)
         {
             uint8_t classification, flight_line, echo_int, x, y, z;
@@ -277,11 +293,15 @@ point_count_t TerrasolidReader::read(PointViewPtr view, point_count_t count)
         if (m_cb)
             m_cb(*view, nextId);
 
+        // Skip the points between those read.
+        m_index += m_stride;
+        if (m_stride > 1 && !eof())
+            m_istream->skip((m_stride - 1) * m_size);
         nextId++;
-        m_index++;
+        numRead++;
     }
 
-    return count;
+    return numRead;
 }
 
 
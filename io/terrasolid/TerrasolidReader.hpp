@@ -97,12 +97,13 @@ class PDAL_DLL TerrasolidReader : public pdal::Reader
 {
 public:
     TerrasolidReader() : pdal::Reader(),
-        m_format(TERRASOLID_Format_Unknown)
+        m_format(TERRASOLID_Format_Unknown), m_stride(1)
     {}
 
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    Options getDefaultOptions();
 
     static Dimension::IdList getDefaultDimensions();
 
@@ -124,7 +125,10 @@ private:
     uint32_t m_baseTime;
     std::unique_ptr<IStream> m_istream;
     point_count_t m_index;
+    // Only every m_stride'th point of the file is read.
+    point_count_t m_stride;
 
+    virtual void processOptions(const Options& options);
     virtual void initialize();
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void ready(PointTableRef table);
@@ -115,6 +115,24 @@ void TextWriter::processOptions(const Options& ops)
 }
 
 
+// Only the dimensions listed in the "order" option are written if other
+// dimensions aren't kept.
+bool TextWriter::usedDimensions(StringList& dims) const
+{
+    if (m_dimOrder.empty() || m_writeAllDims)
+        return false;
+
+    typedef boost::tokenizer<boost::char_separator<char>> tokenizer;
+
+    boost::char_separator<char> separator(", ");
+    tokenizer sdims(m_dimOrder, separator);
+    dims.insert(dims.end(), sdims.begin(), sdims.end());
+    if (m_outputType == "GEOJSON")
+        dims.insert(dims.end(), { "X", "Y", "Z" });
+    return true;
+}
+
+
 void TextWriter::ready(PointTableRef table)
 {
     m_stream->precision(m_precision);
@@ -62,6 +62,7 @@ public:
     std::string getName() const;
 
     Options getDefaultOptions();
+    virtual bool usedDimensions(StringList& dims) const;
 
 private:
     virtual void processOptions(const Options&);
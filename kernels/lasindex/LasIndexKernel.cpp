@@ -0,0 +1,95 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "LasIndexKernel.hpp"
+
+#include <las/LasIndex.hpp>
+
+#include <boost/program_options.hpp>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "kernels.lasindex",
+    "LAS Index Kernel",
+    "http://pdal.io/apps.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, LasIndexKernel, Kernel, s_info)
+
+std::string LasIndexKernel::getName() const
+{
+    return s_info.name;
+}
+
+
+LasIndexKernel::LasIndexKernel()
+{}
+
+
+void LasIndexKernel::validateSwitches()
+{
+    if (m_files.empty())
+        throw app_usage_error("--input/-i required");
+}
+
+
+void LasIndexKernel::addSwitches()
+{
+    po::options_description* file_options =
+        new po::options_description("file options");
+
+    file_options->add_options()
+    ("input,i", po::value<std::vector<std::string>>(&m_files)->multitoken(),
+     "LAS/LAZ files to index")
+    ;
+
+    addSwitchSet(file_options);
+    addPositionalSwitch("input", -1);
+}
+
+
+int LasIndexKernel::execute()
+{
+    for (auto& file : m_files)
+    {
+        LasIndex::create(file);
+        if (isDebug())
+            std::cerr << "Wrote '" << LasIndex::sidecarName(file) << "'." <<
+                std::endl;
+    }
+    return 0;
+}
+
+} // namespace pdal
@@ -38,9 +38,13 @@
 #include <pdal/XMLSchema.hpp>
 #endif
 
+#include <memory>
+
 #include <boost/program_options.hpp>
 
 #include <pdal/PDALUtils.hpp>
+#include <pdal/PointTable.hpp>
+#include <pdal/Trace.hpp>
 
 namespace pdal
 {
@@ -54,7 +58,8 @@ CREATE_STATIC_PLUGIN(1, 0, PipelineKernel, Kernel, s_info)
 
 std::string PipelineKernel::getName() const { return s_info.name; }
 
-PipelineKernel::PipelineKernel() : m_validate(false), m_progressFd(-1)
+PipelineKernel::PipelineKernel() : m_validate(false), m_progressFd(-1),
+    m_threads(1), m_columns(false), m_profile(false)
 {}
 
 
@@ -86,6 +91,17 @@ void PipelineKernel::addSwitches()
             "Name of file or FIFO to which stages should write progress "
             "information.  The file/FIFO must exist.  PDAL will not create "
             "the progress file.")
+        ("threads", po::value<size_t>(&m_threads)->default_value(1),
+            "Maximum number of threads used to run each stage")
+        ("columns",
+            po::value<bool>(&m_columns)->zero_tokens()->implicit_value(true),
+            "Store the values of each dimension together")
+        ("profile",
+            po::value<bool>(&m_profile)->zero_tokens()->implicit_value(true),
+            "Write the time spent and points handled by each stage")
+        ("trace", po::value<std::string>(&m_traceFile),
+            "Name of file to which a timeline of the work done by each "
+            "thread is written, in trace event JSON format")
         ;
 
     addSwitchSet(file_options);
@@ -109,7 +125,9 @@ int PipelineKernel::execute()
     if (m_progressFile.size())
         m_progressFd = Utils::openProgress(m_progressFile);
 
-    pdal::PipelineManager manager(m_progressFd);
+    std::unique_ptr<PointTable> table(m_columns ?
+        new ColumnPointTable : new PointTable);
+    pdal::PipelineManager manager(*table, m_progressFd);
 
     pdal::PipelineReader reader(manager, isDebug(), getVerboseLevel());
     bool isWriter = reader.readPipeline(m_inputFile);
@@ -118,7 +136,17 @@ int PipelineKernel::execute()
             "Use 'pdal info' to read the data.");
 
     applyExtraStageOptionsRecursive(manager.getStage());
+    manager.setThreads(m_threads);
+    if (m_traceFile.size())
+        Trace::start();
     manager.execute();
+    if (m_traceFile.size())
+    {
+        Trace::stop();
+        Trace::write(m_traceFile);
+    }
+    if (m_profile)
+        manager.writeProfile(std::cout);
     if (m_pipelineFile.size() > 0)
     {
         pdal::PipelineWriter writer(manager);
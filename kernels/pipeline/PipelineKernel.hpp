@@ -65,6 +65,10 @@ private:
     std::string m_PointCloudSchemaOutput;
     std::string m_progressFile;
     int m_progressFd;
+    size_t m_threads;
+    bool m_columns;
+    bool m_profile;
+    std::string m_traceFile;
 };
 
 } // pdal
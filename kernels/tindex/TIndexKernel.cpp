@@ -552,6 +552,9 @@ TIndexKernel::FileInfo TIndexKernel::getFileInfo(KernelFactory& factory,
     Options ops;
     ops.add("filename", filename);
     s->setOptions(ops);
+    // Allows options such as a reader's "stride" to limit the points read
+    // to compute the boundary.
+    s->addOptions(extraStageOptions(driverName));
 
     if (m_fastBoundary)
     {
@@ -44,6 +44,7 @@
 #include <pdal/PointView.hpp>
 #include <pdal/Stage.hpp>
 #include <pdal/StageFactory.hpp>
+#include <pdal/Trace.hpp>
 
 #include <memory>
 #include <string>
@@ -75,6 +76,10 @@ TranslateKernel::TranslateKernel()
     , m_pipelineOutput("")
     , m_readerType("")
     , m_writerType("")
+    , m_stream(false)
+    , m_threads(1)
+    , m_columns(false)
+    , m_profile(false)
 {}
 
 void TranslateKernel::validateSwitches()
@@ -105,6 +110,20 @@ void TranslateKernel::addSwitches()
      "filter type")
     ("writer,w", po::value<std::string>(&m_writerType)->default_value(""),
      "writer type")
+    ("stream",
+     po::value<bool>(&m_stream)->zero_tokens()->implicit_value(true),
+     "process points a chunk at a time to limit memory use")
+    ("threads",
+     po::value<size_t>(&m_threads)->default_value(1),
+     "maximum number of threads used to run each stage")
+    ("columns",
+     po::value<bool>(&m_columns)->zero_tokens()->implicit_value(true),
+     "store the values of each dimension together")
+    ("profile",
+     po::value<bool>(&m_profile)->zero_tokens()->implicit_value(true),
+     "write the time spent and points handled by each stage")
+    ("trace", po::value<std::string>(&m_traceFile),
+     "write a timeline of the work done by each thread to this file")
     ;
 
     addSwitchSet(file_options);
@@ -123,7 +142,12 @@ int TranslateKernel::execute()
     setCommonOptions(filterOptions);
     setCommonOptions(writerOptions);
 
-    m_manager = std::unique_ptr<PipelineManager>(new PipelineManager);
+    if (m_columns)
+        m_table.reset(new ColumnPointTable);
+    else
+        m_table.reset(new PointTable);
+    m_manager = std::unique_ptr<PipelineManager>(
+        new PipelineManager(*m_table));
 
     if (!m_readerType.empty())
     {
@@ -200,7 +224,23 @@ int TranslateKernel::execute()
     // be sure to recurse through any extra stage options provided by the user
     applyExtraStageOptionsRecursive(writer);
 
-    m_manager->execute();
+    m_manager->setThreads(m_threads);
+    if (m_traceFile.size())
+        Trace::start();
+    if (m_stream)
+    {
+        StreamPointTable table;
+        m_manager->executeStream(table);
+    }
+    else
+        m_manager->execute();
+    if (m_traceFile.size())
+    {
+        Trace::stop();
+        Trace::write(m_traceFile);
+    }
+    if (m_profile)
+        m_manager->writeProfile(std::cout);
 
     if (m_pipelineOutput.size() > 0)
     {
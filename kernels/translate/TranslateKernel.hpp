@@ -68,7 +68,14 @@ private:
     std::string m_readerType;
     std::vector<std::string> m_filterType;
     std::string m_writerType;
+    bool m_stream;
+    size_t m_threads;
+    bool m_columns;
+    bool m_profile;
+    std::string m_traceFile;
 
+    // Declared before the manager, which refers to it.
+    std::unique_ptr<PointTable> m_table;
     std::unique_ptr<PipelineManager> m_manager;
 };
 
@@ -76,6 +76,10 @@ protected:
         m_istream = NULL;
     }
 
+    // The LAS data is embedded in the NITF file.
+    virtual bool lasFile() const
+        { return false; }
+
 private:
     uint64_t m_offset;
     uint64_t m_length;
@@ -40,6 +40,7 @@
 #include <delta/DeltaKernel.hpp>
 #include <diff/DiffKernel.hpp>
 #include <info/InfoKernel.hpp>
+#include <lasindex/LasIndexKernel.hpp>
 #include <merge/MergeKernel.hpp>
 #include <pipeline/PipelineKernel.hpp>
 #include <random/RandomKernel.hpp>
@@ -67,6 +68,7 @@ KernelFactory::KernelFactory(bool no_plugins)
     PluginManager::initializePlugin(DeltaKernel_InitPlugin);
     PluginManager::initializePlugin(DiffKernel_InitPlugin);
     PluginManager::initializePlugin(InfoKernel_InitPlugin);
+    PluginManager::initializePlugin(LasIndexKernel_InitPlugin);
     PluginManager::initializePlugin(MergeKernel_InitPlugin);
     PluginManager::initializePlugin(PipelineKernel_InitPlugin);
     PluginManager::initializePlugin(RandomKernel_InitPlugin);
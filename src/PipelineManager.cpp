@@ -34,6 +34,9 @@
 
 #include <pdal/PipelineManager.hpp>
 
+#include <iomanip>
+#include <sstream>
+
 namespace pdal
 {
 
@@ -97,6 +100,7 @@ point_count_t PipelineManager::execute()
     Stage *s = getStage();
     if (!s)
         return 0;
+    s->setThreads(m_threads);
     m_viewSet = s->execute(m_table);
     point_count_t cnt = 0;
     for (auto pi = m_viewSet.begin(); pi != m_viewSet.end(); ++pi)
@@ -108,6 +112,53 @@ point_count_t PipelineManager::execute()
 }
 
 
+void PipelineManager::executeStream(StreamPointTable& table)
+{
+    Stage *s = getStage();
+    if (!s)
+        return;
+    s->prepare(table);
+    s->execute(table);
+}
+
+
+void PipelineManager::writeProfile(std::ostream& out) const
+{
+    std::ios::fmtflags flags(out.flags());
+    out << std::fixed << std::setprecision(3);
+    out << std::left << std::setw(24) << "stage" << std::right <<
+        std::setw(11) << "prepare(s)" << std::setw(10) << "wall(s)" <<
+        std::setw(10) << "cpu(s)" << std::setw(13) << "points in" <<
+        std::setw(13) << "points out" << std::setw(7) << "views" <<
+        std::setw(14) << "bytes" << std::endl;
+    bool fused = false;
+    for (auto si = m_stages.begin(); si != m_stages.end(); ++si)
+    {
+        Stage *s = si->get();
+        const StageProfile& p = s->profile();
+
+        std::ostringstream views;
+        views << p.m_viewsIn << "/" << p.m_viewsOut;
+        std::string name = s->getName();
+        if (p.m_fused)
+        {
+            name += "*";
+            fused = true;
+        }
+        out << std::left << std::setw(24) << name << std::right <<
+            std::setw(11) << p.m_prepareTime << std::setw(10) <<
+            p.m_wallTime << std::setw(10) << p.m_cpuTime <<
+            std::setw(13) << p.m_pointsIn << std::setw(13) <<
+            p.m_pointsOut << std::setw(7) << views.str() <<
+            std::setw(14) << p.m_bytesAllocated << std::endl;
+    }
+    if (fused)
+        out << "* Run in a single pass with neighboring filters.  The time "
+            "of the pass is shown for the last filter." << std::endl;
+    out.flags(flags);
+}
+
+
 MetadataNode PipelineManager::getMetadata() const
 {
     MetadataNode output("stages");
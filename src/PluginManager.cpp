@@ -47,7 +47,10 @@
 
 #include "DynamicLibrary.h"
 
+#include <ctime>
+#include <fstream>
 #include <memory>
+#include <set>
 #include <sstream>
 #include <string>
 
@@ -69,33 +72,66 @@ namespace
         return (params && params->createFunc && params->destroyFunc);
     }
 
-    bool pluginTypeValid(std::string pathname, PF_PluginType type)
+    // Get the type of a plugin from its library name, which has the form
+    // libpdal_plugin_{type}_{name}.
+    bool pluginType(const std::string& pathname, PF_PluginType& type)
     {
-        bool valid(false);
-
         if (Utils::startsWith(pathname, "libpdal_plugin_kernel"))
-        {
-            if (type == PF_PluginType_Kernel)
-                valid = true;
-        }
+            type = PF_PluginType_Kernel;
         else if (Utils::startsWith(pathname, "libpdal_plugin_filter"))
-        {
-            if (type == PF_PluginType_Filter)
-                valid = true;
-        }
+            type = PF_PluginType_Filter;
         else if (Utils::startsWith(pathname, "libpdal_plugin_reader"))
+            type = PF_PluginType_Reader;
+        else if (Utils::startsWith(pathname, "libpdal_plugin_writer"))
+            type = PF_PluginType_Writer;
+        else
+            return false;
+        return true;
+    }
+
+    bool pluginTypeValid(std::string pathname, PF_PluginType type)
+    {
+        PF_PluginType t;
+        return pluginType(pathname, t) && t == type;
+    }
+
+    std::string pluginSearchPath()
+    {
+        std::string pluginDir = Utils::getenv("PDAL_DRIVER_PATH");
+
+        // If we don't have a driver path, defaults are set.
+        if (pluginDir.size() == 0)
         {
-            if (type == PF_PluginType_Reader)
-                valid = true;
+            std::ostringstream oss;
+            oss << PDAL_PLUGIN_INSTALL_PATH <<
+                ":/usr/local/lib:./lib:../lib:../bin";
+            pluginDir = oss.str();
         }
-        else if (Utils::startsWith(pathname, "libpdal_plugin_writer"))
+        return pluginDir;
+    }
+
+    // Absolute paths of the plugin directories that exist.
+    std::vector<std::string> pluginDirectories()
+    {
+        std::vector<std::string> dirs;
+        for (const auto& dir : Utils::split2(pluginSearchPath(), ':'))
         {
-            if (type == PF_PluginType_Writer)
-                valid = true;
+            boost::system::error_code ec;
+            if (dir.size() && boost::filesystem::is_directory(dir, ec))
+                dirs.push_back(boost::filesystem::complete(dir).string());
         }
+        return dirs;
+    }
 
-        return valid;
+    std::time_t modTime(const std::string& path)
+    {
+        boost::system::error_code ec;
+        std::time_t t = boost::filesystem::last_write_time(path, ec);
+        return ec ? 0 : t;
     }
+
+    const std::string manifestHeader("# PDAL plugin manifest "
+        PDAL_VERSION_STRING);
 }
 
 
@@ -128,19 +164,8 @@ PluginManager& PluginManager::getInstance()
 
 void PluginManager::loadAll(PF_PluginType type)
 {
-    std::string driver_path("PDAL_DRIVER_PATH");
-    std::string pluginDir = Utils::getenv(driver_path);
-
-    // If we don't have a driver path, defaults are set.
-    if (pluginDir.size() == 0)
-    {
-        std::ostringstream oss;
-        oss << PDAL_PLUGIN_INSTALL_PATH <<
-            ":/usr/local/lib:./lib:../lib:../bin";
-        pluginDir = oss.str();
-    }
-
-    std::vector<std::string> pluginPathVec = Utils::split2(pluginDir, ':');
+    std::vector<std::string> pluginPathVec =
+        Utils::split2(pluginSearchPath(), ':');
 
     for (const auto& pluginPath : pluginPathVec)
     {
@@ -196,7 +221,7 @@ bool PluginManager::initializePlugin(PF_InitFunc initFunc)
 }
 
 
-PluginManager::PluginManager()
+PluginManager::PluginManager() : m_manifestReady(false)
 {
     m_version.major = 1;
     m_version.minor = 0;
@@ -235,6 +260,9 @@ bool PluginManager::shutdown()
     m_dynamicLibraryMap.clear();
     m_exactMatchMap.clear();
     m_exitFuncVec.clear();
+    m_libraryDrivers.clear();
+    m_manifest.clear();
+    m_manifestReady = false;
 
     return success;
 }
@@ -280,42 +308,124 @@ bool PluginManager::loadPlugin(const std::string& driverFileName)
     return false;
 }
 
-bool PluginManager::guessLoadByPath(const std::string& driverName)
+std::string PluginManager::manifestFilename()
 {
-    // parse the driver name into an expected pluginName, e.g.,
-    // writers.las => libpdal_plugin_writer_las
-
-    std::vector<std::string> driverNameVec;
-    driverNameVec = Utils::split2(driverName, '.');
+    std::string filename = Utils::getenv("PDAL_PLUGIN_MANIFEST");
+    if (filename.size())
+        return filename;
 
-    std::string pluginName = "libpdal_plugin_" + driverNameVec[0] + "_" +
-        driverNameVec[1];
+    std::string dir = Utils::getenv("XDG_CACHE_HOME");
+    if (dir.empty())
+    {
+        dir = Utils::getenv("HOME");
+        if (dir.size())
+            dir += "/.cache";
+    }
+    if (dir.empty())
+        dir = boost::filesystem::temp_directory_path().string();
+    return (boost::filesystem::path(dir) / "pdal" /
+        "plugins.manifest").string();
+}
 
-    std::string driver_path("PDAL_DRIVER_PATH");
-    std::string pluginDir = Utils::getenv(driver_path);
 
-    // Default path below if not set.
-    if (pluginDir.size() == 0)
+// Load the plugin library that provides a driver, as recorded in the
+// manifest.  The manifest is checked against the plugin directories once
+// per process.  If it's missing or out of date, every plugin is loaded to
+// find the drivers it provides and the manifest is rewritten.
+bool PluginManager::loadByManifest(const std::string& driverName)
+{
+    if (!m_manifestReady)
     {
-        std::ostringstream oss;
-        oss << PDAL_PLUGIN_INSTALL_PATH <<
-            ":/usr/local/lib:./lib:../lib:../bin";
-        pluginDir = oss.str();
+        m_manifestReady = true;
+        std::string filename = manifestFilename();
+        if (!readManifest(filename))
+        {
+            buildManifest();
+            writeManifest(filename);
+        }
     }
 
-    std::vector<std::string> pluginPathVec = Utils::split2(pluginDir, ':');
-    for (const auto& pluginPath : pluginPathVec)
+    auto it = m_manifest.find(driverName);
+    if (it == m_manifest.end())
+        return false;
+
+    boost::filesystem::path path(it->second);
+    PF_PluginType type;
+    if (!pluginType(Utils::tolower(path.filename().string()), type))
+        return false;
+    return loadByPath(path.string(), type);
+}
+
+
+// Read the manifest, returning false if it doesn't exist or if the
+// plugin search path, a plugin directory or a plugin library has changed
+// since it was written.
+bool PluginManager::readManifest(const std::string& filename)
+{
+    std::ifstream in(filename);
+    std::string line;
+    if (!std::getline(in, line) || line != manifestHeader)
+        return false;
+
+    bool pathValid(false);
+    std::set<std::string> dirs;
+    std::map<std::string, std::string> manifest;
+    while (std::getline(in, line))
     {
-        boost::filesystem::path path(pluginPath);
+        std::istringstream iss(line);
+        std::string key;
+        std::string name;
+        std::time_t t(0);
+        std::string path;
+
+        iss >> key;
+        if (key == "dir" || key == "lib")
+            iss >> t;
+        else if (key == "driver")
+            iss >> name;
+        iss.get();
+        std::getline(iss, path);
+        if (!iss && !iss.eof())
+            return false;
+
+        if (key == "path")
+        {
+            if (path != pluginSearchPath())
+                return false;
+            pathValid = true;
+        }
+        else if (key == "dir" || key == "lib")
+        {
+            if (modTime(path) != t)
+                return false;
+            if (key == "dir")
+                dirs.insert(path);
+        }
+        else if (key == "driver")
+            manifest[name] = path;
+        else
+            return false;
+    }
 
-        if (!FileUtils::fileExists(path.string()) ||
-            !boost::filesystem::is_directory(path))
-            continue;
+    // A plugin directory that's been created since the manifest was
+    // written may hold plugins that aren't listed.
+    for (const auto& dir : pluginDirectories())
+        if (!dirs.count(dir))
+            return false;
 
-        boost::filesystem::directory_iterator dir(path), it, end;
-        // Looks like directory_iterator doesn't support range-based for loop in
-        // Boost v1.55. It fails Travis anyway, so I reverted it.
-        for (it = dir; it != end; ++it)
+    m_manifest.swap(manifest);
+    return pathValid;
+}
+
+
+// Load every plugin library in the plugin directories and record the
+// drivers that each provides.
+void PluginManager::buildManifest()
+{
+    for (const auto& dir : pluginDirectories())
+    {
+        boost::filesystem::directory_iterator it(dir), end;
+        for (; it != end; ++it)
         {
             boost::filesystem::path full_path = it->path();
 
@@ -326,32 +436,54 @@ bool PluginManager::guessLoadByPath(const std::string& driverName)
             if (ext != dynamicLibraryExtension)
                 continue;
 
-            std::string stem = full_path.stem().string();
-            std::string::size_type pos = stem.find_last_of('_');
-            if (pos == std::string::npos || pos == stem.size() - 1 ||
-                    stem.substr(pos + 1) != driverNameVec[1])
-                continue;
-
             PF_PluginType type;
-            if (driverNameVec[0] == "readers")
-                type = PF_PluginType_Reader;
-            else if (driverNameVec[0] == "kernels")
-                type = PF_PluginType_Kernel;
-            else if (driverNameVec[0] == "filters")
-                type = PF_PluginType_Filter;
-            else if (driverNameVec[0] == "writers")
-                type = PF_PluginType_Writer;
-            else
-                type = PF_PluginType_Reader;
-
-            if (loadByPath(full_path.string(), type))
-            {
-                return true;
-            }
+            if (pluginType(Utils::tolower(full_path.filename().string()),
+                    type))
+                loadByPath(full_path.string(), type);
         }
     }
 
-    return false;
+    m_manifest.clear();
+    for (auto const& lib : m_libraryDrivers)
+        for (auto const& driver : lib.second)
+            m_manifest[driver] = lib.first;
+}
+
+
+// Write the manifest.  It's only a cache, so failure is ignored.
+void PluginManager::writeManifest(const std::string& filename)
+{
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code ec;
+    fs::path path(filename);
+    if (path.has_parent_path())
+        fs::create_directories(path.parent_path(), ec);
+
+    // Write a temporary file and rename it so that processes started at
+    // the same time never read a partial manifest.
+    fs::path temp(path.string() + fs::unique_path(".%%%%-%%%%").string());
+    {
+        std::ofstream out(temp.string());
+        out << manifestHeader << std::endl;
+        out << "path " << pluginSearchPath() << std::endl;
+        for (const auto& dir : pluginDirectories())
+            out << "dir " << modTime(dir) << " " << dir << std::endl;
+        for (auto const& lib : m_libraryDrivers)
+            out << "lib " << modTime(lib.first) << " " << lib.first <<
+                std::endl;
+        for (auto const& m : m_manifest)
+            out << "driver " << m.first << " " << m.second << std::endl;
+        if (!out)
+        {
+            out.close();
+            fs::remove(temp, ec);
+            return;
+        }
+    }
+    fs::rename(temp, path, ec);
+    if (ec)
+        fs::remove(temp, ec);
 }
 
 
@@ -377,6 +509,7 @@ bool PluginManager::loadByPath(const std::string& pluginPath,
     {
         std::string errorString;
         auto completePath(boost::filesystem::complete(path).string());
+        RegistrationMap before(m_exactMatchMap);
 
         if (DynamicLibrary *d = loadLibrary(completePath, errorString))
         {
@@ -386,6 +519,12 @@ bool PluginManager::loadByPath(const std::string& pluginPath,
                 loaded = initializePlugin(initFunc);
             }
         }
+
+        // Note the drivers the library registered for the manifest.
+        std::vector<std::string>& drivers = m_libraryDrivers[completePath];
+        for (auto const& r : m_exactMatchMap)
+            if (!before.count(r.first))
+                drivers.push_back(r.first);
     }
 
     return loaded;
@@ -400,7 +539,12 @@ void *PluginManager::createObject(const std::string& objectType)
         return m_exactMatchMap.count(objectType);
     });
 
-    if (find() || (guessLoadByPath(objectType) && find()))
+    // The manifest may be rebuilt to find the driver, which loads the
+    // library that provides it, so check again whether or not the library
+    // was loaded here.
+    if (!find())
+        loadByManifest(objectType);
+    if (find())
     {
         obj = m_exactMatchMap[objectType].createFunc();
     }
@@ -0,0 +1,274 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/PointIndex.hpp>
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace pdal
+{
+
+namespace
+{
+
+inline int popcount(uint64_t word)
+{
+#ifdef _MSC_VER
+    return (int)__popcnt64(word);
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+// Position of the lowest set bit.  'word' must not be zero.
+inline int lowestBit(uint64_t word)
+{
+#ifdef _MSC_VER
+    unsigned long pos;
+    _BitScanForward64(&pos, word);
+    return (int)pos;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+inline bool isSet(const std::vector<uint64_t>& mask, PointId pos)
+{
+    size_t word = pos >> 6;
+    return word < mask.size() && (mask[word] & ((uint64_t)1 << (pos & 63)));
+}
+
+} // unnamed namespace
+
+
+// Add the 'count' IDs starting with 'start'.
+void PointIndex::push_back(PointId start, point_count_t count)
+{
+    if (count == 0)
+        return;
+    if (m_mode == Range)
+    {
+        if (m_count == 0)
+            m_start = start;
+        if (start == m_start + m_count)
+        {
+            m_count += count;
+            return;
+        }
+    }
+    expand();
+    m_ids->reserve(m_ids->size() + count);
+    for (point_count_t i = 0; i < count; ++i)
+        m_ids->push_back(start + i);
+}
+
+
+// Insert 'count' entries of 'src', starting with the one at position
+// 'srcPos', before position 'pos'.
+void PointIndex::insert(point_count_t pos, const PointIndex& src,
+    PointId srcPos, point_count_t count)
+{
+    if (count == 0)
+        return;
+    if (src.m_mode == Range && pos == size())
+    {
+        push_back(src.m_start + srcPos, count);
+        return;
+    }
+
+    // Read the source IDs first, since 'src' may be this index.
+    std::vector<PointId> ids(count);
+    src.getIds(srcPos, count, ids.data());
+    expand();
+    m_ids->insert(m_ids->begin() + pos, ids.begin(), ids.end());
+}
+
+
+// Create an index of the entries of this index at the positions whose bits
+// are set in 'keep'.  'count' is the number of bits set.  Positions past
+// the end of 'keep' aren't selected.
+PointIndex PointIndex::select(const std::vector<uint64_t>& keep,
+    point_count_t count) const
+{
+    if (count == size())
+        return *this;
+
+    PointIndex out;
+    if (count == 0)
+        return out;
+
+    // Selections always refer to a range or a list, so selecting from a
+    // selection combines the two masks over the same base.
+    std::vector<uint64_t> mask;
+    point_count_t baseSize;
+    if (m_mode == Selection)
+    {
+        baseSize = m_mask.size() * 64;
+        mask.resize(m_mask.size());
+        PointId basePos = 0;
+        for (PointId i = 0; i < m_count; ++i, ++basePos)
+        {
+            basePos = nextSelected(basePos);
+            if (isSet(keep, i))
+                mask[basePos >> 6] |= (uint64_t)1 << (basePos & 63);
+        }
+    }
+    else
+    {
+        baseSize = size();
+        mask = keep;
+        mask.resize((baseSize + 63) / 64);
+    }
+
+    // A list of a few points takes less space and is faster than a sparse
+    // mask over a large base.
+    if (count * 32 < baseSize)
+    {
+        out.m_mode = List;
+        out.m_ids.reset(new std::vector<PointId>);
+        out.m_ids->reserve(count);
+        for (size_t w = 0; w < mask.size(); ++w)
+            for (uint64_t word = mask[w]; word; word &= word - 1)
+                out.m_ids->push_back(baseId((w << 6) + lowestBit(word)));
+        return out;
+    }
+
+    out.m_mode = Selection;
+    out.m_start = m_start;
+    out.m_count = count;
+    out.m_ids = m_ids;
+    out.m_mask.swap(mask);
+    out.buildRanks();
+    return out;
+}
+
+
+// Find the base position of the point at position 'i' of a selection.
+PointId PointIndex::select(PointId i) const
+{
+    // Find the last group of words with no more than 'i' points before it
+    // and count bits from there.
+    size_t group = std::upper_bound(m_ranks.begin(), m_ranks.end(), i) -
+        m_ranks.begin() - 1;
+    point_count_t remaining = i - m_ranks[group];
+    size_t w = group * m_rankWords;
+    uint64_t word = m_mask[w];
+    point_count_t bits;
+    while (remaining >= (bits = (point_count_t)popcount(word)))
+    {
+        remaining -= bits;
+        word = m_mask[++w];
+    }
+    while (remaining--)
+        word &= word - 1;
+
+    return (w << 6) + lowestBit(word);
+}
+
+
+// Find the first selected base position at or after 'basePos'.  There
+// must be one.
+PointId PointIndex::nextSelected(PointId basePos) const
+{
+    size_t w = basePos >> 6;
+    uint64_t word = m_mask[w] & (~(uint64_t)0 << (basePos & 63));
+    while (!word)
+        word = m_mask[++w];
+    return (w << 6) + lowestBit(word);
+}
+
+
+// Get the IDs of the 'count' entries starting at position 'pos'.  The
+// entries of a selection after the first are found by walking its mask,
+// which is faster than looking each one up.
+void PointIndex::getIds(PointId pos, point_count_t count, PointId *ids) const
+{
+    if (count == 0)
+        return;
+    if (m_mode != Selection)
+    {
+        for (point_count_t i = 0; i < count; ++i)
+            ids[i] = (*this)[pos + i];
+        return;
+    }
+
+    PointId basePos = select(pos);
+    for (point_count_t i = 0; i < count; ++i, ++basePos)
+    {
+        basePos = nextSelected(basePos);
+        ids[i] = baseId(basePos);
+    }
+}
+
+
+void PointIndex::buildRanks()
+{
+    m_ranks.clear();
+    m_ranks.reserve(m_mask.size() / m_rankWords + 1);
+    point_count_t total = 0;
+    for (size_t w = 0; w < m_mask.size(); ++w)
+    {
+        if (w % m_rankWords == 0)
+            m_ranks.push_back(total);
+        total += popcount(m_mask[w]);
+    }
+}
+
+
+// Switch to a list of IDs that isn't shared with another index.
+void PointIndex::expand()
+{
+    if (m_mode == List)
+    {
+        if (m_ids.use_count() > 1)
+            m_ids.reset(new std::vector<PointId>(*m_ids));
+        return;
+    }
+
+    std::shared_ptr<std::vector<PointId>> ids(new std::vector<PointId>);
+    ids->reserve(m_count + 1);
+    ids->resize(m_count);
+    getIds(0, m_count, ids->data());
+    m_ids = ids;
+    m_mode = List;
+    m_count = 0;
+    m_mask.clear();
+    m_ranks.clear();
+}
+
+} // namespace pdal
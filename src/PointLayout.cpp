@@ -59,6 +59,27 @@ void PointLayout::finalize()
     m_finalized = true;
 }
 
+bool PointLayout::equal(const PointLayout& other) const
+{
+    if (this == &other)
+        return true;
+    if (m_pointSize != other.m_pointSize ||
+        m_used.size() != other.m_used.size())
+        return false;
+    for (auto id : m_used)
+    {
+        Dimension::Id::Enum otherId = other.findDim(dimName(id));
+        if (otherId != id)
+            return false;
+        const Dimension::Detail *d = dimDetail(id);
+        const Dimension::Detail *od = other.dimDetail(id);
+        if (d->type() != od->type() || d->offset() != od->offset())
+            return false;
+    }
+    return true;
+}
+
+
 void PointLayout::registerDims(std::vector<Dimension::Id::Enum> ids)
 {
     for (auto ii = ids.begin(); ii != ids.end(); ++ii)
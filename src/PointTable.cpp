@@ -33,6 +33,18 @@
 ****************************************************************************/
 
 #include <pdal/PointTable.hpp>
+#include <pdal/util/Utils.hpp>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 namespace pdal
 {
@@ -63,29 +75,277 @@ MetadataNode BasePointTable::privateMetadata(const std::string& name)
 }
 
 
+namespace
+{
+
+// Freed memory blocks, kept for reuse by any point table in the process
+// so that pipelines run one after another don't page-fault and zero new
+// memory for every block.
+class BlockPool
+{
+public:
+    BlockPool() : m_size(0), m_limit(256 * 1024 * 1024)
+        {}
+    ~BlockPool()
+    {
+        for (auto& bi : m_blocks)
+            release(bi.second, bi.first);
+    }
+
+    static BlockPool& instance()
+    {
+        static BlockPool pool;
+        return pool;
+    }
+
+    void setLimit(std::size_t limit)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_limit = limit;
+        while (m_size > m_limit && m_blocks.size())
+        {
+            auto bi = m_blocks.begin();
+            release(bi->second, bi->first);
+            m_size -= bi->first;
+            m_blocks.erase(bi);
+        }
+    }
+
+    // Get a block of 'size' bytes, allocating one if none is available.
+    // 'reused' is set if the block may contain old data.
+    char *get(std::size_t size, bool hugePages, bool& reused)
+    {
+        // A layout with no dimensions has zero-size blocks.  There's no
+        // storage to map, so they all share a placeholder address.
+        if (size == 0)
+        {
+            reused = false;
+            return emptyBlock();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto bi = m_blocks.find(size);
+            if (bi != m_blocks.end())
+            {
+                char *block = bi->second;
+                m_blocks.erase(bi);
+                m_size -= size;
+                reused = true;
+                if (hugePages)
+                    adviseHugePages(block, size);
+                return block;
+            }
+        }
+        reused = false;
+        return allocate(size, hugePages);
+    }
+
+    // Return a block to the pool, or to the system if the pool is full.
+    void put(char *block, std::size_t size)
+    {
+        if (size == 0)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_size + size <= m_limit)
+            {
+                m_blocks.insert(std::make_pair(size, block));
+                m_size += size;
+                return;
+            }
+        }
+        release(block, size);
+    }
+
+private:
+    std::multimap<std::size_t, char *> m_blocks;
+    std::size_t m_size;
+    std::size_t m_limit;
+    std::mutex m_mutex;
+
+    static char *emptyBlock()
+    {
+        static char empty;
+        return &empty;
+    }
+
+    // Memory from the system is zero-filled as it's first touched, so
+    // there's no need to clear it.
+    static char *allocate(std::size_t size, bool hugePages)
+    {
+#ifdef _WIN32
+        char *block = (char *)calloc(1, size);
+        if (!block)
+            throw std::bad_alloc();
+#else
+        void *addr = ::mmap(NULL, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED)
+            throw std::bad_alloc();
+        char *block = (char *)addr;
+        if (hugePages)
+            adviseHugePages(block, size);
+#endif
+        return block;
+    }
+
+    static void adviseHugePages(char *block, std::size_t size)
+    {
+#ifdef MADV_HUGEPAGE
+        ::madvise(block, size, MADV_HUGEPAGE);
+#endif
+    }
+
+    static void release(char *block, std::size_t size)
+    {
+#ifdef _WIN32
+        free(block);
+#else
+        ::munmap(block, size);
+#endif
+    }
+};
+
+// Compute log2 of a point count, or -1 if it isn't a power of two.
+int blockShift(point_count_t cnt)
+{
+    for (int shift = 0; shift < 32; ++shift)
+        if (cnt == ((point_count_t)1 << shift))
+            return shift;
+    return -1;
+}
+
+} // unnamed namespace
+
+
+void BasePointTable::addPoints(point_count_t count, PointIndex& index)
+{
+    for (point_count_t i = 0; i < count; ++i)
+        index.push_back(addPoint());
+}
+
+
+PointTable::PointTable(point_count_t blockPtCnt) : m_numPts(0),
+    m_layout(new PointLayout()), m_blockPtCnt(blockPtCnt),
+    m_blockShift(blockShift(blockPtCnt)), m_zeroFill(true),
+    m_hugePages(false), m_allocatedBytes(0)
+{
+    if (m_blockShift < 10)
+    {
+        std::ostringstream oss;
+        oss << "Invalid point table block size " << blockPtCnt << ".  "
+            "Block size must be a power of two no smaller than 1024.";
+        throw pdal_error(oss.str());
+    }
+
+    // Size the top level of the directory to cover all possible points.
+    uint64_t maxBlocks = ((uint64_t)1 << 32) >> m_blockShift;
+    m_blocks.resize((size_t)((maxBlocks + m_dirSize - 1) / m_dirSize));
+}
+
+
 PointTable::~PointTable()
 {
-    for (auto vi = m_blocks.begin(); vi != m_blocks.end(); ++vi)
-        delete [] *vi;
+    clearBlocks();
 }
 
-PointId PointTable::addPoint()
+
+void PointTable::setPoolLimit(std::size_t bytes)
+{
+    BlockPool::instance().setLimit(bytes);
+}
+
+
+void PointTable::clearBlocks()
 {
-    if (m_numPts % m_blockPtCnt == 0)
+    size_t size = pointsToBytes(m_blockPtCnt);
+    for (size_t i = 0; i < m_blocks.size() && m_blocks[i]; ++i)
     {
-        size_t size = pointsToBytes(m_blockPtCnt);
-        char *buf = new char[size];
-        memset(buf, 0, size);
-        m_blocks.push_back(buf);
+        for (point_count_t j = 0; j < m_dirSize; ++j)
+            if (m_blocks[i][j])
+                freeBlock(m_blocks[i][j], size);
+        delete [] m_blocks[i];
+        m_blocks[i] = NULL;
     }
+    m_numPts = 0;
+    m_allocatedBytes = 0;
+}
+
+
+char *PointTable::allocateBlock(std::size_t size)
+{
+    bool reused;
+    char *block = BlockPool::instance().get(size, m_hugePages, reused);
+    if (reused && m_zeroFill)
+        memset(block, 0, size);
+    return block;
+}
+
+
+void PointTable::freeBlock(char *block, std::size_t size)
+{
+    BlockPool::instance().put(block, size);
+}
+
+
+// Points may be added from separate threads when pipeline branches are
+// executed concurrently.
+PointId PointTable::addPoint()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    allocateBlocks(1);
     return m_numPts++;
 }
 
 
+// The IDs of the added points are consecutive, so they're added to the
+// index as a range.
+void PointTable::addPoints(point_count_t count, PointIndex& index)
+{
+    if (count == 0)
+        return;
+
+    PointId first;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        allocateBlocks(count);
+        first = m_numPts;
+        m_numPts += count;
+    }
+    index.push_back(first, count);
+}
+
+
+// Make sure there are blocks to hold the next 'numPts' points.  Called
+// with the table locked.
+void PointTable::allocateBlocks(point_count_t numPts)
+{
+    point_count_t first = m_numPts >> m_blockShift;
+    if (blockOffset(m_numPts))
+        first++;
+    point_count_t last = (m_numPts + numPts - 1) >> m_blockShift;
+    for (point_count_t block = first; block <= last; ++block)
+    {
+        char **&dir = m_blocks[block / m_dirSize];
+        if (!dir)
+            dir = new char *[m_dirSize]();
+
+        // The block may be left from an earlier failed allocation.
+        if (!dir[block % m_dirSize])
+        {
+            dir[block % m_dirSize] =
+                allocateBlock(pointsToBytes(m_blockPtCnt));
+            m_allocatedBytes += pointsToBytes(m_blockPtCnt);
+        }
+    }
+}
+
+
 char *PointTable::getPoint(PointId idx)
 {
-    char *buf = m_blocks[idx / m_blockPtCnt];
-    return buf + pointsToBytes(idx % m_blockPtCnt);
+    return getBlock(idx) + pointsToBytes(blockOffset(idx));
 }
 
 
@@ -100,5 +360,290 @@ void PointTable::getField(const Dimension::Detail *d, PointId idx, void *value)
     std::memcpy(value, getDimension(d, idx), d->size());
 }
 
+
+void ColumnPointTable::setField(const Dimension::Detail *d, PointId idx,
+    const void *value)
+{
+    std::memcpy(getDimension(d, idx), value, d->size());
+}
+
+
+void ColumnPointTable::getField(const Dimension::Detail *d, PointId idx,
+    void *value)
+{
+    std::memcpy(value, getDimension(d, idx), d->size());
+}
+
+
+MappedPointTable::MappedPointTable(const std::string& scratchDir,
+        std::size_t budget) : m_scratchDir(scratchDir), m_budget(budget),
+    m_fd(-1), m_fileSize(0), m_blockSize(0), m_residentSize(0),
+    m_hasPending(false)
+{
+#ifdef _WIN32
+    throw pdal_error("Memory-mapped point tables aren't supported on "
+        "Windows.");
+#else
+    if (m_scratchDir.empty())
+        m_scratchDir = Utils::getenv(std::string("TMPDIR"));
+    if (m_scratchDir.empty())
+        m_scratchDir = "/tmp";
+
+    uint64_t maxBlocks = ((uint64_t)1 << 32) / blockPtCnt();
+    m_released.reset(new std::atomic<bool>[(size_t)maxBlocks]());
+#endif
+}
+
+
+MappedPointTable::~MappedPointTable()
+{
+    m_pending.clear();
+    clearBlocks();
+#ifndef _WIN32
+    if (m_fd >= 0)
+        ::close(m_fd);
+#endif
+}
+
+
+// Blocks are mapped at page-aligned offsets in the scratch file.  A
+// zero-size block (a layout with no dimensions) still gets a page, since
+// an empty mapping can't be made.
+std::size_t MappedPointTable::mappedSize(std::size_t size) const
+{
+#ifdef _WIN32
+    return size;
+#else
+    std::size_t pageSize = (std::size_t)sysconf(_SC_PAGESIZE);
+    if (size == 0)
+        return pageSize;
+    return ((size + pageSize - 1) / pageSize) * pageSize;
+#endif
+}
+
+
+void MappedPointTable::openScratch()
+{
+#ifndef _WIN32
+    std::string filename(m_scratchDir);
+    if (filename.back() != '/')
+        filename += '/';
+    filename += "pdal-XXXXXX";
+    std::vector<char> name(filename.begin(), filename.end());
+    name.push_back(0);
+
+    m_fd = mkstemp(name.data());
+    if (m_fd < 0)
+    {
+        std::ostringstream oss;
+        oss << "Unable to create scratch file in '" << m_scratchDir <<
+            "': " << strerror(errno) << ".";
+        throw pdal_error(oss.str());
+    }
+    // The mapping keeps the file around until the table is destroyed.
+    ::unlink(name.data());
+#endif
+}
+
+
+char *MappedPointTable::allocateBlock(std::size_t size)
+{
+#ifdef _WIN32
+    return PointTable::allocateBlock(size);
+#else
+    if (m_fd < 0)
+        openScratch();
+
+    // Extending the file provides zero-filled storage for the new block.
+    size = mappedSize(size);
+    if (::ftruncate(m_fd, (off_t)(m_fileSize + size)) != 0)
+    {
+        std::ostringstream oss;
+        oss << "Unable to extend scratch file to " << (m_fileSize + size) <<
+            " bytes: " << strerror(errno) << ".";
+        throw pdal_error(oss.str());
+    }
+    void *addr = ::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+        m_fd, (off_t)m_fileSize);
+    if (addr == MAP_FAILED)
+    {
+        std::ostringstream oss;
+        oss << "Unable to map scratch file block: " << strerror(errno) << ".";
+        throw pdal_error(oss.str());
+    }
+    // Blocks are mapped in order, so the block number follows from the
+    // position in the file.
+    point_count_t blockNum = (point_count_t)(m_fileSize / size);
+    m_fileSize += size;
+    if (!m_blockSize)
+        m_blockSize = size;
+
+    // The table is locked here, so blocks pushed out of the budget are
+    // released once the points have been added.
+    char *block = (char *)addr;
+    std::lock_guard<std::mutex> lock(m_residentMutex);
+    addResident(block, blockNum);
+    return block;
+#endif
+}
+
+
+std::size_t MappedPointTable::residentSize()
+{
+    std::lock_guard<std::mutex> lock(m_residentMutex);
+    return m_residentSize;
+}
+
+
+// Count a block as resident and queue the blocks that became resident
+// first to be released to stay within the budget.  The new block is
+// always kept since it's about to be used.  Called with the resident
+// blocks locked.
+void MappedPointTable::addResident(char *block, point_count_t blockNum)
+{
+    m_released[blockNum] = false;
+    m_resident.push(std::make_pair(block, blockNum));
+    m_residentSize += m_blockSize;
+    while (m_residentSize > m_budget && m_resident.size() > 1)
+    {
+        std::pair<char *, point_count_t> old = m_resident.front();
+        m_resident.pop();
+        m_released[old.second] = true;
+        m_pending.push_back(old.first);
+        m_residentSize -= m_blockSize;
+    }
+    if (m_pending.size())
+        m_hasPending = true;
+}
+
+
+// Write out and release the queued blocks.  This is done without the
+// table or the resident blocks locked, since writing a block waits for
+// I/O.  A block accessed again before it's released is just paged back
+// in.
+void MappedPointTable::releasePending()
+{
+#ifndef _WIN32
+    if (!m_hasPending)
+        return;
+
+    std::vector<char *> blocks;
+    {
+        std::lock_guard<std::mutex> lock(m_residentMutex);
+        blocks.swap(m_pending);
+        m_hasPending = false;
+    }
+    for (char *block : blocks)
+    {
+        ::msync(block, m_blockSize, MS_SYNC);
+        ::madvise(block, m_blockSize, MADV_DONTNEED);
+    }
+#endif
+}
+
+
+// Count a released block that's being accessed as resident again.
+void MappedPointTable::reload(PointId idx)
+{
+    point_count_t blockNum = idx / blockPtCnt();
+    {
+        std::lock_guard<std::mutex> lock(m_residentMutex);
+        if (!m_released[blockNum])
+            return;
+        addResident(getBlock(idx), blockNum);
+    }
+    releasePending();
+}
+
+
+PointId MappedPointTable::addPoint()
+{
+    PointId id = PointTable::addPoint();
+    releasePending();
+    return id;
+}
+
+
+void MappedPointTable::addPoints(point_count_t count, PointIndex& index)
+{
+    PointTable::addPoints(count, index);
+    releasePending();
+}
+
+
+char *MappedPointTable::getPoint(PointId idx)
+{
+    if (m_released[idx / blockPtCnt()].load(std::memory_order_relaxed))
+        reload(idx);
+    return PointTable::getPoint(idx);
+}
+
+
+void MappedPointTable::freeBlock(char *block, std::size_t size)
+{
+#ifdef _WIN32
+    PointTable::freeBlock(block, size);
+#else
+    ::munmap(block, mappedSize(size));
+#endif
+}
+
+
+PointId StreamPointTable::addPoint()
+{
+    if (m_numPts >= m_capacity)
+    {
+        std::ostringstream oss;
+        oss << "Can't add point to stream point table.  Capacity of " <<
+            m_capacity << " points exceeded.";
+        throw pdal_error(oss.str());
+    }
+
+    // The layout can't change once points are added, so allocate the
+    // storage the first time it's needed.
+    if (m_buf.empty())
+        m_buf.resize(pointsToBytes(m_capacity));
+
+    // Points are reused, so clear any data left from the previous chunk.
+    char *pos = getPoint(m_numPts);
+    memset(pos, 0, pointsToBytes(1));
+    return m_numPts++;
+}
+
+
+void StreamPointTable::addPoints(point_count_t count, PointIndex& index)
+{
+    if (count == 0)
+        return;
+    if (m_numPts + count > m_capacity)
+    {
+        std::ostringstream oss;
+        oss << "Can't add " << count << " points to stream point table.  "
+            "Capacity of " << m_capacity << " points exceeded.";
+        throw pdal_error(oss.str());
+    }
+
+    if (m_buf.empty())
+        m_buf.resize(pointsToBytes(m_capacity));
+
+    memset(getPoint(m_numPts), 0, pointsToBytes(count));
+    index.push_back(m_numPts, count);
+    m_numPts += count;
+}
+
+
+void StreamPointTable::setField(const Dimension::Detail *d, PointId idx,
+    const void *value)
+{
+    std::memcpy(getPoint(idx) + d->offset(), value, d->size());
+}
+
+
+void StreamPointTable::getField(const Dimension::Detail *d, PointId idx,
+    void *value)
+{
+    std::memcpy(value, getPoint(idx) + d->offset(), d->size());
+}
+
 } // namespace pdal
 
@@ -56,6 +56,70 @@ PointViewIter PointView::end()
 }
 
 
+/// Add copies of points from another view, which may use a different
+/// point table, to the end of this view.  Fields for dimensions that aren't
+/// in this view's layout are dropped.  If the layouts are identical, runs of
+/// points stored together in both tables are copied with a single memcpy.
+/// \param src  View containing the points to copy.
+/// \param start  Index in 'src' of the first point to copy.
+/// \param count  Number of points to copy.
+void PointView::copyPoints(const PointView& src, PointId start,
+    point_count_t count)
+{
+    if (count == 0)
+        return;
+
+    PointId first = addPoints(count);
+    PointLayoutPtr layout = m_pointTable.layout();
+    PointLayoutPtr srcLayout = src.m_pointTable.layout();
+
+    point_count_t i = 0;
+    if (layout->equal(*srcLayout))
+    {
+        size_t pointSize = layout->pointSize();
+        while (i < count)
+        {
+            char *from = src.m_pointTable.getPoint(src.m_index[start + i]);
+            char *to = m_pointTable.getPoint(m_index[first + i]);
+            // Tables without packed points are copied by field below.
+            if (!from || !to)
+                break;
+
+            point_count_t run = 1;
+            while (i + run < count &&
+                src.m_pointTable.getPoint(src.m_index[start + i + run]) ==
+                    from + run * pointSize &&
+                m_pointTable.getPoint(m_index[first + i + run]) ==
+                    to + run * pointSize)
+                run++;
+            memcpy(to, from, run * pointSize);
+            i += run;
+        }
+    }
+    if (i == count)
+        return;
+
+    DimTypeList dims;
+    std::vector<Dimension::Id::Enum> srcDims;
+    for (auto id : layout->dims())
+    {
+        Dimension::Id::Enum srcId = srcLayout->findDim(layout->dimName(id));
+        if (srcId == Dimension::Id::Unknown)
+            continue;
+        dims.push_back(DimType(id, layout->dimType(id)));
+        srcDims.push_back(srcId);
+    }
+
+    char buf[sizeof(double)];
+    for (; i < count; ++i)
+        for (size_t d = 0; d < dims.size(); ++d)
+        {
+            src.getField(buf, srcDims[d], dims[d].m_type, start + i);
+            setField(dims[d].m_id, dims[d].m_type, first + i, buf);
+        }
+}
+
+
 void PointView::calculateBounds(BOX2D& output) const
 {
     for (PointId idx = 0; idx < size(); idx++)
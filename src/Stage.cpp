@@ -32,21 +32,66 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
+#include <pdal/Filter.hpp>
 #include <pdal/GlobalEnvironment.hpp>
+#include <pdal/Reader.hpp>
 #include <pdal/Stage.hpp>
 #include <pdal/SpatialReference.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <pdal/Trace.hpp>
 #include <pdal/UserCallback.hpp>
+#include <pdal/Writer.hpp>
 
 #include "StageRunner.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <future>
+#include <limits>
 #include <memory>
+#include <mutex>
 
 namespace pdal
 {
 
+namespace
+{
+
+BOX3D unbounded()
+{
+    const double lowest = (std::numeric_limits<double>::lowest)();
+    const double highest = (std::numeric_limits<double>::max)();
+
+    return BOX3D(lowest, lowest, lowest, highest, highest, highest);
+}
+
+
+// Measures elapsed wall clock and process CPU time.
+class Timer
+{
+public:
+    Timer() : m_wall(std::chrono::steady_clock::now()), m_cpu(std::clock())
+        {}
+
+    double wall() const
+    {
+        return std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - m_wall).count();
+    }
+    double cpu() const
+        { return (std::clock() - m_cpu) / (double)CLOCKS_PER_SEC; }
+
+private:
+    std::chrono::steady_clock::time_point m_wall;
+    std::clock_t m_cpu;
+};
+
+} // unnamed namespace
+
 
 Stage::Stage()
-  : m_callback(new UserCallback), m_progressFd(-1)
+  : m_callback(new UserCallback), m_progressFd(-1), m_threads(1)
 {
     Construct();
 }
@@ -68,53 +113,168 @@ void Stage::Construct()
 {
     m_debug = false;
     m_verbose = 0;
+    m_allDims = true;
+    m_boundsHint = unbounded();
 }
 
 
 void Stage::prepare(PointTableRef table)
 {
-    for (size_t i = 0; i < m_inputs.size(); ++i)
-    {
-        Stage *prev = m_inputs[i];
-        prev->prepare(table);
-    }
+    // Options are processed for the whole pipeline first so that the
+    // dimensions read by later stages are known when readers add
+    // dimensions to the table.  The points of any stage other than a
+    // writer are returned to the caller, so all dimensions are used.
+    processStageOptions();
+    clearHints();
+    bool writer = (dynamic_cast<Writer *>(this) != NULL);
+    pushUsedDimensions(!writer, std::set<std::string>());
+    pushBoundsHint(unbounded());
+    prepareStage(table);
+}
+
+
+void Stage::processStageOptions()
+{
+    for (Stage *prev : m_inputs)
+        prev->processStageOptions();
+
+    m_profile = StageProfile();
+    TraceScope trace("prepare", getName());
+    Timer timer;
     l_processOptions(m_options);
     processOptions(m_options);
+    m_profile.m_prepareTime = timer.wall();
+}
+
+
+void Stage::prepareStage(PointTableRef table)
+{
+    for (Stage *prev : m_inputs)
+        prev->prepareStage(table);
+
+    TraceScope trace("prepare", getName());
+    Timer timer;
     l_initialize(table);
     initialize();
     addDimensions(table.layout());
     prepared(table);
+    m_profile.m_prepareTime += timer.wall();
+}
+
+
+void Stage::clearHints()
+{
+    m_allDims = false;
+    m_usedDims.clear();
+    m_boundsHint.clear();
+    for (Stage *prev : m_inputs)
+        prev->clearHints();
+}
+
+
+// Add the dimensions read by the stages that follow this one ('dims', or
+// any dimension if 'all' is set) and those read by this stage, and pass
+// them to the input stages.  A stage that feeds more than one stage sees
+// the dimensions read by each.
+void Stage::pushUsedDimensions(bool all, const std::set<std::string>& dims)
+{
+    StringList names;
+    if (!usedDimensions(names))
+        all = true;
+
+    m_allDims = m_allDims || all;
+    m_usedDims.insert(dims.begin(), dims.end());
+    for (const std::string& name : names)
+    {
+        // Use the standard spelling of names of known dimensions.
+        Dimension::Id::Enum id = Dimension::id(name);
+        m_usedDims.insert(id == Dimension::Id::Unknown ?
+            name : Dimension::name(id));
+    }
+
+    for (Stage *prev : m_inputs)
+        prev->pushUsedDimensions(m_allDims, m_usedDims);
+}
+
+
+// Add the bounds outside of which the stages that follow this one don't
+// use points, limited to the bounds of this stage, and pass them to the
+// input stages.
+void Stage::pushBoundsHint(BOX3D bounds)
+{
+    if (!pointwise())
+        bounds = unbounded();
+
+    BOX3D crop;
+    if (cropBounds(crop))
+        bounds.clip(crop);
+
+    m_boundsHint.grow(bounds);
+    for (Stage *prev : m_inputs)
+        prev->pushBoundsHint(m_boundsHint);
 }
 
 
 PointViewSet Stage::execute(PointTableRef table)
 {
+    // The layout is finalized here, before any branches of the pipeline
+    // are run on other threads.
     table.layout()->finalize();
+    return executeStage(table);
+}
+
+
+// Execute the pipeline ending at this stage once the layout is final.
+PointViewSet Stage::executeStage(PointTableRef table)
+{
+    std::vector<Filter *> chain = fusedFilters();
+    if (chain.size() > 1)
+        return executeFused(table, chain);
 
     PointViewSet views;
     if (m_inputs.empty())
     {
         views.insert(PointViewPtr(new PointView(table)));
     }
+    else if (m_inputs.size() > 1 && m_threads > 1)
+    {
+        views = executeInputs(table);
+    }
     else
     {
         for (size_t i = 0; i < m_inputs.size(); ++i)
         {
             Stage *prev = m_inputs[i];
-            PointViewSet temp = prev->execute(table);
+            PointViewSet temp = prev->executeStage(table);
             views.insert(temp.begin(), temp.end());
         }
     }
 
+    Timer timer;
+    std::size_t bytes = table.allocatedBytes();
+
     PointViewSet outViews;
     std::vector<StageRunnerPtr> runners;
 
-    ready(table);
+    // The pool is declared after the runners so that its threads are
+    // joined before the runners they reference are destroyed.
+    std::unique_ptr<ThreadPool> pool;
+    size_t threads = (std::min)(m_threads, views.size());
+    if (parallelizable() && threads > 1)
+        pool.reset(new ThreadPool(threads));
+
+    {
+        std::lock_guard<std::mutex> lock(table.stageMutex());
+        ready(table);
+    }
     for (auto const& it : views)
     {
         StageRunnerPtr runner(new StageRunner(this, it));
         runners.push_back(runner);
-        runner->run();
+        if (pool)
+            runner->run(*pool);
+        else
+            runner->run();
     }
     for (auto const& it : runners)
     {
@@ -122,12 +282,319 @@ PointViewSet Stage::execute(PointTableRef table)
         PointViewSet temp = runner->wait();
         outViews.insert(temp.begin(), temp.end());
     }
-    l_done(table);
-    done(table);
+    {
+        std::lock_guard<std::mutex> lock(table.stageMutex());
+        l_done(table);
+        done(table);
+    }
+    addProfile(timer.wall(), timer.cpu(), views, outViews,
+        table.allocatedBytes() - bytes);
+    profileMetadata();
     return outViews;
 }
 
 
+// Find the run of fusable filters ending with this stage, in pipeline
+// order.
+std::vector<Filter *> Stage::fusedFilters()
+{
+    std::vector<Filter *> chain;
+
+    Stage *s = this;
+    while (s->m_inputs.size() == 1)
+    {
+        Filter *f = dynamic_cast<Filter *>(s);
+        if (!f || !f->fusable())
+            break;
+        chain.insert(chain.begin(), f);
+        s = s->m_inputs.front();
+    }
+    return chain;
+}
+
+
+// Run a chain of fusable filters, passing each point through all of the
+// filters before moving to the next point.  As when streaming, each filter
+// is readied and sets the spatial reference for the next one before any
+// points are processed.
+PointViewSet Stage::executeFused(PointTableRef table,
+    const std::vector<Filter *>& chain)
+{
+    PointViewSet views =
+        chain.front()->m_inputs.front()->executeStage(table);
+
+    std::string name;
+    for (Filter *f : chain)
+        name += (name.empty() ? "" : " + ") + f->getName();
+    TraceScope trace("run", name);
+    Timer timer;
+    std::size_t bytes = table.allocatedBytes();
+    {
+        std::lock_guard<std::mutex> lock(table.stageMutex());
+        for (Filter *f : chain)
+        {
+            f->ready(table);
+            f->l_done(table);
+        }
+    }
+
+    auto runChain = [&chain](PointView& v)
+    {
+        return v.select([&chain, &v](PointId idx)
+        {
+            for (Filter *f : chain)
+                if (!f->processOne(v, idx))
+                    return false;
+            return true;
+        });
+    };
+
+    // As when the filters aren't fused, views are run on separate threads
+    // if every filter of the chain is parallelizable.
+    bool parallel = true;
+    for (Filter *f : chain)
+        parallel = parallel && f->parallelizable();
+    size_t threads = (std::min)(m_threads, views.size());
+
+    PointViewSet outViews;
+    if (parallel && threads > 1)
+    {
+        typedef std::packaged_task<PointViewPtr()> Task;
+
+        std::vector<std::future<PointViewPtr>> results;
+        {
+            ThreadPool pool(threads);
+            for (auto const& view : views)
+            {
+                auto task = std::make_shared<Task>(
+                    [&runChain, view](){ return runChain(*view); });
+                results.push_back(task->get_future());
+                pool.add([task](){ (*task)(); });
+            }
+        }
+        // Rethrow the first error encountered.
+        for (auto& r : results)
+            outViews.insert(r.get());
+    }
+    else
+    {
+        for (auto const& view : views)
+            outViews.insert(runChain(*view));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(table.stageMutex());
+        for (Filter *f : chain)
+        {
+            f->l_done(table);
+            f->done(table);
+        }
+    }
+
+    for (Filter *f : chain)
+    {
+        if (f == this)
+            f->addProfile(timer.wall(), timer.cpu(), views, outViews,
+                table.allocatedBytes() - bytes);
+        else
+            f->addProfile(0, 0, views, outViews, 0);
+        f->m_profile.m_fused = true;
+        f->profileMetadata();
+    }
+    return outViews;
+}
+
+
+/// Execute the branches of the pipeline that feed this stage at the same
+/// time, using up to m_threads threads.  Branches share the point table,
+/// which supports adding points from separate threads.  Because view ids
+/// are assigned as views are created, the order of the views from separate
+/// branches isn't fixed.
+///
+/// \param[in] table  Point table shared by all branches.
+/// \return  Views produced by all of the input stages.
+///
+PointViewSet Stage::executeInputs(PointTableRef table)
+{
+    typedef std::packaged_task<PointViewSet()> Task;
+
+    std::vector<std::future<PointViewSet>> results;
+    {
+        ThreadPool pool((std::min)(m_threads, m_inputs.size()));
+        for (Stage *prev : m_inputs)
+        {
+            auto task = std::make_shared<Task>(
+                [prev, &table](){ return prev->executeStage(table); });
+            results.push_back(task->get_future());
+            pool.add([task](){ (*task)(); });
+        }
+    }
+
+    // Every branch has completed once the pool is gone.  Collect the
+    // views, rethrowing the first error encountered.
+    PointViewSet views;
+    for (auto& r : results)
+    {
+        PointViewSet temp = r.get();
+        views.insert(temp.begin(), temp.end());
+    }
+    return views;
+}
+
+
+/// Run the pipeline ending at this stage in streaming mode.  The source
+/// reader fills the table with at most table.capacity() points, the chunk
+/// is pushed through each stage in turn and the table is then reset for the
+/// next chunk, so memory use is bounded regardless of the input size.
+///
+/// \param[in] table  Fixed-size table used to hold each chunk of points.
+///
+void Stage::execute(StreamPointTable& table)
+{
+    if (!pipelineStreamable())
+    {
+        std::ostringstream oss;
+        oss << "Pipeline ending at stage '" << getName() << "' can't be "
+            "run in streaming mode.";
+        throw pdal_error(oss.str());
+    }
+
+    table.layout()->finalize();
+
+    std::vector<Stage *> stages = streamStages();
+    Reader *reader = dynamic_cast<Reader *>(stages.front());
+    if (!reader)
+        throw pdal_error("Streaming pipeline must begin with a reader.");
+
+    // Downstream stages may depend on the spatial reference of their
+    // inputs, so push it along as each stage is readied.  Each stage's
+    // done hooks run once, after all the points have been processed.
+    for (Stage *s : stages)
+    {
+        s->ready(table);
+        const SpatialReference& srs = s->getSpatialReference();
+        if (!srs.empty())
+            table.setSpatialRef(srs);
+    }
+
+    point_count_t remaining = reader->m_count;
+    while (remaining)
+    {
+        table.reset();
+        PointViewPtr view(new PointView(table));
+        Timer readTimer;
+        point_count_t count;
+        {
+            TraceScope trace("read", reader->getName());
+            count = reader->read(view,
+                (std::min)(remaining, table.capacity()));
+        }
+        if (count == 0)
+            break;
+        remaining -= count;
+
+        PointViewSet views;
+        views.insert(view);
+        reader->addProfile(readTimer.wall(), readTimer.cpu(), PointViewSet(),
+            views, 0);
+        for (auto si = stages.begin() + 1; si != stages.end(); ++si)
+        {
+            TraceScope trace("run", (*si)->getName());
+            Timer timer;
+            PointViewSet outViews;
+            for (auto const& v : views)
+            {
+                PointViewSet temp = (*si)->run(v);
+                outViews.insert(temp.begin(), temp.end());
+            }
+            (*si)->addProfile(timer.wall(), timer.cpu(), views, outViews, 0);
+            views.swap(outViews);
+        }
+    }
+
+    for (Stage *s : stages)
+    {
+        s->l_done(table);
+        s->done(table);
+        s->profileMetadata();
+    }
+}
+
+
+// Add the measurements of one run of the stage to its profile.
+void Stage::addProfile(double wallTime, double cpuTime,
+    const PointViewSet& in, const PointViewSet& out, std::size_t bytes)
+{
+    m_profile.m_wallTime += wallTime;
+    m_profile.m_cpuTime += cpuTime;
+    m_profile.m_viewsIn += in.size();
+    m_profile.m_viewsOut += out.size();
+    for (auto const& v : in)
+        m_profile.m_pointsIn += v->size();
+    for (auto const& v : out)
+        m_profile.m_pointsOut += v->size();
+    m_profile.m_bytesAllocated += bytes;
+}
+
+
+void Stage::profileMetadata()
+{
+    MetadataNode m = m_metadata.add("profile");
+    m.add("prepare_time", m_profile.m_prepareTime,
+        "Seconds spent preparing the stage");
+    m.add("wall_time", m_profile.m_wallTime,
+        "Seconds spent running the stage");
+    m.add("cpu_time", m_profile.m_cpuTime,
+        "Seconds of process CPU time used while running the stage");
+    m.add("points_in", m_profile.m_pointsIn);
+    m.add("points_out", m_profile.m_pointsOut);
+    m.add("views_in", m_profile.m_viewsIn);
+    m.add("views_out", m_profile.m_viewsOut);
+    m.add("bytes_allocated", m_profile.m_bytesAllocated,
+        "Bytes of point storage allocated while running the stage");
+    m.add("fused", m_profile.m_fused);
+}
+
+
+/// Set the maximum number of threads used to run this stage and the
+/// stages that feed it.  Only stages that are parallelizable() make use of
+/// more than one thread.
+///
+/// \param[in] threads  Maximum number of threads.
+///
+void Stage::setThreads(size_t threads)
+{
+    m_threads = threads ? threads : 1;
+    for (Stage *s : m_inputs)
+        s->setThreads(threads);
+}
+
+
+bool Stage::pipelineStreamable() const
+{
+    if (!streamable() || m_inputs.size() > 1)
+        return false;
+    return m_inputs.empty() || m_inputs.front()->pipelineStreamable();
+}
+
+
+// Return the stages of a linear pipeline from the source to this stage.
+std::vector<Stage *> Stage::streamStages()
+{
+    std::vector<Stage *> stages;
+
+    Stage *s = this;
+    stages.push_back(s);
+    while (s->m_inputs.size())
+    {
+        s = s->m_inputs.front();
+        stages.push_back(s);
+    }
+    std::reverse(stages.begin(), stages.end());
+    return stages;
+}
+
+
 void Stage::l_initialize(PointTableRef table)
 {
     m_metadata = table.metadata().add(getName());
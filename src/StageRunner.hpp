@@ -34,9 +34,12 @@
 
 #pragma once
 
+#include <future>
 #include <memory>
 
 #include <pdal/Stage.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <pdal/Trace.hpp>
 
 namespace pdal
 {
@@ -48,17 +51,39 @@ public:
         m_stage(s), m_view(view)
     {}
 
-    // For now this is all synchronous
+    // Run the stage on the view in the calling thread.
     void run()
-        { m_viewSet = m_stage->run(m_view); }
+    {
+        std::packaged_task<PointViewSet()> task(
+            [this](){ return runStage(); });
+        m_result = task.get_future();
+        task();
+    }
 
+    // Queue the stage to be run on the view by a thread in the pool.
+    void run(ThreadPool& pool)
+    {
+        auto task = std::make_shared<std::packaged_task<PointViewSet()>>(
+            [this](){ return runStage(); });
+        m_result = task->get_future();
+        pool.add([task](){ (*task)(); });
+    }
+
+    // Wait for the run to complete and return its output.  Any exception
+    // thrown by the stage is rethrown here.
     PointViewSet wait()
-        { return m_viewSet; }
+        { return m_result.get(); }
 
 private:
     Stage *m_stage;
     PointViewPtr m_view;
-    PointViewSet m_viewSet;
+    std::future<PointViewSet> m_result;
+
+    PointViewSet runStage()
+    {
+        TraceScope trace("run", m_stage->getName());
+        return m_stage->run(m_view);
+    }
 };
 typedef std::shared_ptr<StageRunner> StageRunnerPtr;
 
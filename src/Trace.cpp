@@ -0,0 +1,194 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/Trace.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/Utils.hpp>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace pdal
+{
+
+namespace
+{
+
+struct TraceEvent
+{
+    std::string m_category;
+    std::string m_name;
+    Trace::TimePoint m_start;
+    Trace::TimePoint m_end;
+    size_t m_thread;
+};
+
+std::atomic<bool> s_enabled(false);
+std::mutex s_mutex;
+Trace::TimePoint s_origin;
+std::vector<TraceEvent> s_events;
+std::map<std::thread::id, size_t> s_threads;
+
+// Number the threads in the order that they're first seen so that the
+// viewer shows them in a stable order.  Call with the mutex held.
+size_t threadIndex()
+{
+    auto it = s_threads.find(std::this_thread::get_id());
+    if (it != s_threads.end())
+        return it->second;
+    size_t idx = s_threads.size();
+    s_threads[std::this_thread::get_id()] = idx;
+    return idx;
+}
+
+double micros(Trace::TimePoint t)
+{
+    return std::chrono::duration<double, std::micro>(t - s_origin).count();
+}
+
+} // unnamed namespace
+
+
+void Trace::start()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_events.clear();
+    s_threads.clear();
+    s_origin = std::chrono::steady_clock::now();
+    threadIndex();
+    s_enabled = true;
+}
+
+
+void Trace::stop()
+{
+    s_enabled = false;
+}
+
+
+bool Trace::enabled()
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+
+void Trace::record(const std::string& category, const std::string& name,
+    TimePoint start, TimePoint end)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    TraceEvent e;
+    e.m_category = category;
+    e.m_name = name;
+    e.m_start = start;
+    e.m_end = end;
+    e.m_thread = threadIndex();
+    s_events.push_back(e);
+}
+
+
+/// Write the recorded events as a trace event JSON object.  Each span is
+/// a complete ("X") event with times in microseconds.
+///
+/// \param[in] out  Stream to which the trace is written.
+///
+void Trace::write(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    out << "{\"traceEvents\":[" << std::endl;
+    for (auto const& t : s_threads)
+    {
+        std::string name = t.second ? "worker " +
+            std::to_string(t.second) : "main";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"tid\":" << t.second << ",\"args\":{\"name\":\"" << name <<
+            "\"}}," << std::endl;
+    }
+    for (auto const& e : s_events)
+    {
+        out << "{\"name\":\"" << Utils::escapeJSON(e.m_name) <<
+            "\",\"cat\":\"" << Utils::escapeJSON(e.m_category) <<
+            "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.m_thread <<
+            ",\"ts\":" << std::fixed << micros(e.m_start) <<
+            ",\"dur\":" << (micros(e.m_end) - micros(e.m_start)) <<
+            "}," << std::endl;
+        out.unsetf(std::ios_base::floatfield);
+    }
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+        "\"args\":{\"name\":\"pdal\"}}" << std::endl;
+    out << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+}
+
+
+/// Write the recorded events to a file.
+///
+/// \param[in] filename  Name of the file to create.
+///
+void Trace::write(const std::string& filename)
+{
+    std::ostream *out = FileUtils::createFile(filename, false);
+    if (!out)
+    {
+        std::ostringstream oss;
+        oss << "Unable to open trace file '" << filename << "'.";
+        throw pdal_error(oss.str());
+    }
+    write(*out);
+    FileUtils::closeFile(out);
+}
+
+
+TraceScope::TraceScope(const char *category, const std::string& name) :
+    m_active(Trace::enabled()), m_category(category)
+{
+    if (m_active)
+    {
+        m_name = name;
+        m_start = std::chrono::steady_clock::now();
+    }
+}
+
+
+TraceScope::~TraceScope()
+{
+    if (m_active)
+        Trace::record(m_category, m_name, m_start,
+            std::chrono::steady_clock::now());
+}
+
+} // namespace pdal
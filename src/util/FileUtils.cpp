@@ -33,6 +33,10 @@
 ****************************************************************************/
 
 #include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include <iostream>
 #include <sstream>
@@ -186,6 +190,19 @@ uintmax_t FileUtils::fileSize(const string& file)
 }
 
 
+void FileUtils::adviseDontNeed(const string& filename, uintmax_t offset,
+    uintmax_t length)
+{
+#ifdef POSIX_FADV_DONTNEED
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+        return;
+    ::posix_fadvise(fd, (off_t)offset, (off_t)length, POSIX_FADV_DONTNEED);
+    ::close(fd);
+#endif
+}
+
+
 string FileUtils::readFileIntoString(const string& filename)
 {
     istream* stream = FileUtils::openFile(filename, false);
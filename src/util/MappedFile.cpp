@@ -0,0 +1,131 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/util/MappedFile.hpp>
+
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pdal
+{
+
+namespace
+{
+
+#ifndef _WIN32
+// Round an advice range out to whole pages, as madvise() requires an
+// aligned start address.
+void advise(char *data, uintmax_t size, uintmax_t offset, uintmax_t length,
+    int advice)
+{
+    if (offset >= size)
+        return;
+    length = (std::min)(length, size - offset);
+
+    uintmax_t pageSize = (uintmax_t)::sysconf(_SC_PAGESIZE);
+    uintmax_t start = offset - (offset % pageSize);
+    ::madvise(data + start, (size_t)(offset + length - start), advice);
+}
+#endif
+
+} // unnamed namespace
+
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+#ifdef _WIN32
+    (void)filename;
+    return false;
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // The mapping holds its own reference to the file, so the descriptor
+    // isn't needed once the file is mapped.
+    void *addr = ::mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED,
+        fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        return false;
+    m_data = (char *)addr;
+    m_size = (uintmax_t)st.st_size;
+    return true;
+#endif
+}
+
+
+void MappedFile::close()
+{
+#ifndef _WIN32
+    if (m_data)
+        ::munmap(m_data, (size_t)m_size);
+#endif
+    m_data = NULL;
+    m_size = 0;
+}
+
+
+void MappedFile::adviseSequential(uintmax_t offset, uintmax_t length)
+{
+#ifndef _WIN32
+    if (m_data)
+        advise(m_data, m_size, offset, length, MADV_SEQUENTIAL);
+#endif
+}
+
+
+void MappedFile::adviseWillNeed(uintmax_t offset, uintmax_t length)
+{
+#ifndef _WIN32
+    if (m_data)
+        advise(m_data, m_size, offset, length, MADV_WILLNEED);
+#endif
+}
+
+} // namespace pdal
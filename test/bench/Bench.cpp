@@ -0,0 +1,574 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+// Microbenchmarks for the hot paths of the core library.  All inputs are
+// synthesized with FauxReader from a fixed seed so runs are comparable
+// between builds and releases.
+//
+// Usage: pdal_bench [--points N] [--repeat N] [--seed N] [--filter TEXT]
+//                   [--tmpdir DIR] [--json FILE] [--list]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <pdal/BufferReader.hpp>
+#include <pdal/Compression.hpp>
+#include <pdal/KDIndex.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/QuadIndex.hpp>
+#include <pdal/pdal_config.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/Utils.hpp>
+
+#include <BpfReader.hpp>
+#include <BpfWriter.hpp>
+#include <FauxReader.hpp>
+#include <LasReader.hpp>
+#include <LasWriter.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+struct Config
+{
+    Config() : m_points(1000000), m_repeat(5), m_seed(42), m_list(false)
+    {}
+
+    point_count_t m_points;
+    int m_repeat;
+    unsigned m_seed;
+    std::string m_filter;
+    std::string m_tmpdir;
+    std::string m_json;
+    bool m_list;
+};
+
+
+// A benchmark runs its body once per repetition and returns the number of
+// items (points or queries) handled, from which the rate is computed.
+struct Benchmark
+{
+    std::string m_name;
+    std::string m_unit;
+    std::function<point_count_t ()> m_body;
+};
+
+
+struct Result
+{
+    std::string m_name;
+    std::string m_unit;
+    point_count_t m_count;
+    double m_best;
+    double m_median;
+
+    double rate() const
+        { return m_best > 0 ? m_count / m_best : 0; }
+};
+
+
+// Shared synthetic inputs, built once and reused by every benchmark.
+class Fixture
+{
+public:
+    Fixture(const Config& config)
+    {
+        std::string dir = config.m_tmpdir.empty() ? FileUtils::getcwd() :
+            config.m_tmpdir;
+        m_lasFile = FileUtils::toAbsolutePath("pdal_bench.las", dir);
+        m_bpfFile = FileUtils::toAbsolutePath("pdal_bench.bpf", dir);
+
+        // Points are scattered in a 1000 unit cube.  Random mode draws from
+        // rand(), so seeding it makes the data identical between runs.
+        Utils::random_seed(config.m_seed);
+
+        Options ops;
+        ops.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+        ops.add("num_points", config.m_points);
+        ops.add("mode", "random");
+        ops.add("number_of_returns", 3);
+
+        FauxReader reader;
+        reader.setOptions(ops);
+        reader.prepare(m_table);
+        PointViewSet viewSet = reader.execute(m_table);
+        m_view = *viewSet.begin();
+    }
+
+    ~Fixture()
+    {
+        FileUtils::deleteFile(m_lasFile);
+        FileUtils::deleteFile(m_bpfFile);
+    }
+
+    PointTable& table()
+        { return m_table; }
+    PointView& view()
+        { return *m_view; }
+
+    // Write the fixture points to the LAS file and return the point count.
+    point_count_t writeLas()
+    {
+        BufferReader reader;
+        reader.addView(m_view);
+
+        Options ops;
+        ops.add("filename", m_lasFile);
+        ops.add("minor_version", 2);
+        ops.add("dataformat_id", 3);
+        ops.add("scale_x", .01);
+        ops.add("scale_y", .01);
+        ops.add("scale_z", .01);
+
+        LasWriter writer;
+        writer.setOptions(ops);
+        writer.setInput(reader);
+        writer.prepare(m_table);
+        writer.execute(m_table);
+        return m_view->size();
+    }
+
+    point_count_t readLas()
+    {
+        if (!FileUtils::fileExists(m_lasFile))
+            writeLas();
+
+        Options ops;
+        ops.add("filename", m_lasFile);
+
+        PointTable table;
+        LasReader reader;
+        reader.setOptions(ops);
+        reader.prepare(table);
+        return count(reader.execute(table));
+    }
+
+    point_count_t writeBpf()
+    {
+        BufferReader reader;
+        reader.addView(m_view);
+
+        Options ops;
+        ops.add("filename", m_bpfFile);
+        ops.add("compression", true);
+
+        BpfWriter writer;
+        writer.setOptions(ops);
+        writer.setInput(reader);
+        writer.prepare(m_table);
+        writer.execute(m_table);
+        return m_view->size();
+    }
+
+    point_count_t readBpf()
+    {
+        if (!FileUtils::fileExists(m_bpfFile))
+            writeBpf();
+
+        Options ops;
+        ops.add("filename", m_bpfFile);
+
+        PointTable table;
+        BpfReader reader;
+        reader.setOptions(ops);
+        reader.prepare(table);
+        return count(reader.execute(table));
+    }
+
+    KD3Index& kdIndex()
+    {
+        if (!m_kdIndex)
+        {
+            m_kdIndex.reset(new KD3Index(*m_view));
+            m_kdIndex->build();
+        }
+        return *m_kdIndex;
+    }
+
+    QuadIndex& quadIndex()
+    {
+        if (!m_quadIndex)
+            m_quadIndex.reset(new QuadIndex(*m_view));
+        return *m_quadIndex;
+    }
+
+#ifdef PDAL_HAVE_LAZPERF
+    std::vector<unsigned char>& lazBuf()
+    {
+        if (m_lazBuf.empty())
+            compress(m_lazBuf);
+        return m_lazBuf;
+    }
+
+    point_count_t compress(std::vector<unsigned char>& out)
+    {
+        out.clear();
+        LazPerfBuf buf(out);
+        DimTypeList dimTypes = m_table.layout()->dimTypes();
+        LazPerfCompressor<LazPerfBuf> compressor(buf, dimTypes);
+
+        std::vector<char> point(compressor.pointSize());
+        for (PointId idx = 0; idx < m_view->size(); ++idx)
+        {
+            m_view->getPackedPoint(dimTypes, idx, point.data());
+            compressor.compress(point.data(), point.size());
+        }
+        compressor.done();
+        return m_view->size();
+    }
+#endif
+
+private:
+    PointTable m_table;
+    PointViewPtr m_view;
+    std::string m_lasFile;
+    std::string m_bpfFile;
+    std::unique_ptr<KD3Index> m_kdIndex;
+    std::unique_ptr<QuadIndex> m_quadIndex;
+#ifdef PDAL_HAVE_LAZPERF
+    std::vector<unsigned char> m_lazBuf;
+#endif
+
+    static point_count_t count(const PointViewSet& viewSet)
+    {
+        point_count_t cnt = 0;
+        for (auto const& v : viewSet)
+            cnt += v->size();
+        return cnt;
+    }
+};
+
+
+std::vector<Benchmark> benchmarks(Fixture& f, const Config& config)
+{
+    using namespace Dimension;
+
+    std::vector<Benchmark> list;
+
+    // Keep the index query counts bounded so that large inputs don't make
+    // the query benchmarks dominate the run.
+    const point_count_t queries = std::min<point_count_t>(config.m_points,
+        100000);
+
+    list.push_back({"view.getFieldAs", "points", [&f]()
+    {
+        PointView& v = f.view();
+        double sum = 0;
+        for (PointId idx = 0; idx < v.size(); ++idx)
+        {
+            sum += v.getFieldAs<double>(Id::X, idx);
+            sum += v.getFieldAs<double>(Id::Y, idx);
+            sum += v.getFieldAs<double>(Id::Z, idx);
+            sum += v.getFieldAs<uint8_t>(Id::ReturnNumber, idx);
+        }
+        // Keep the loop from being optimized away.
+        if (sum < 0)
+            std::cerr << sum;
+        return v.size();
+    }});
+
+    list.push_back({"view.setField", "points", [&f]()
+    {
+        PointView& v = f.view();
+        for (PointId idx = 0; idx < v.size(); ++idx)
+        {
+            // Write back the values read so the fixture data is unchanged.
+            double x = v.getFieldAs<double>(Id::X, idx);
+            double y = v.getFieldAs<double>(Id::Y, idx);
+            uint8_t r = v.getFieldAs<uint8_t>(Id::ReturnNumber, idx);
+            v.setField(Id::X, idx, x);
+            v.setField(Id::Y, idx, y);
+            v.setField(Id::ReturnNumber, idx, r);
+        }
+        return v.size();
+    }});
+
+    list.push_back({"las.write", "points", [&f]()
+        { return f.writeLas(); }});
+    list.push_back({"las.read", "points", [&f]()
+        { return f.readLas(); }});
+    list.push_back({"bpf.write.zlib", "points", [&f]()
+        { return f.writeBpf(); }});
+    list.push_back({"bpf.read.zlib", "points", [&f]()
+        { return f.readBpf(); }});
+
+#ifdef PDAL_HAVE_LAZPERF
+    list.push_back({"lazperf.compress", "points", [&f]()
+    {
+        std::vector<unsigned char> out;
+        return f.compress(out);
+    }});
+
+    list.push_back({"lazperf.decompress", "points", [&f]()
+    {
+        LazPerfBuf buf(f.lazBuf());
+        DimTypeList dimTypes = f.table().layout()->dimTypes();
+        LazPerfDecompressor<LazPerfBuf> decompressor(buf, dimTypes);
+
+        std::vector<char> point(decompressor.pointSize());
+        for (PointId idx = 0; idx < f.view().size(); ++idx)
+            decompressor.decompress(point.data(), point.size());
+        return f.view().size();
+    }});
+#endif
+
+    list.push_back({"kd3.build", "points", [&f]()
+    {
+        KD3Index index(f.view());
+        index.build();
+        return f.view().size();
+    }});
+
+    list.push_back({"kd3.neighbors", "queries", [&f, queries]()
+    {
+        KD3Index& index = f.kdIndex();
+        PointView& v = f.view();
+        const PointId step = v.size() / queries;
+        for (PointId idx = 0; idx < queries; ++idx)
+        {
+            PointId id = idx * step;
+            index.neighbors(v.getFieldAs<double>(Id::X, id),
+                v.getFieldAs<double>(Id::Y, id),
+                v.getFieldAs<double>(Id::Z, id), 8);
+        }
+        return queries;
+    }});
+
+    // Choose the radius so that a sphere holds about ten points on average.
+    const double radius = std::cbrt(10 * 1e9 * 3 /
+        (4 * 3.14159265358979 * config.m_points));
+    list.push_back({"kd3.radius", "queries", [&f, queries, radius]()
+    {
+        KD3Index& index = f.kdIndex();
+        PointView& v = f.view();
+        const PointId step = v.size() / queries;
+        for (PointId idx = 0; idx < queries; ++idx)
+        {
+            PointId id = idx * step;
+            index.radius(v.getFieldAs<double>(Id::X, id),
+                v.getFieldAs<double>(Id::Y, id),
+                v.getFieldAs<double>(Id::Z, id), radius);
+        }
+        return queries;
+    }});
+
+    list.push_back({"quad.build", "points", [&f]()
+    {
+        QuadIndex index(f.view());
+        return f.view().size();
+    }});
+
+    // Boxes cover 1% of the area, so each returns about 1% of the points.
+    const point_count_t boxes = std::max<point_count_t>(queries / 100, 1);
+    list.push_back({"quad.getPoints", "queries", [&f, boxes]()
+    {
+        QuadIndex& index = f.quadIndex();
+        for (point_count_t i = 0; i < boxes; ++i)
+        {
+            double x = (i * 37 % 90) * 10.0;
+            double y = (i * 53 % 90) * 10.0;
+            index.getPoints(x, y, x + 100, y + 100);
+        }
+        return boxes;
+    }});
+
+    return list;
+}
+
+
+Result run(const Benchmark& b, int repeat)
+{
+    using namespace std::chrono;
+
+    Result r;
+    r.m_name = b.m_name;
+    r.m_unit = b.m_unit;
+    r.m_count = 0;
+
+    std::vector<double> times;
+    for (int i = 0; i < repeat; ++i)
+    {
+        steady_clock::time_point start = steady_clock::now();
+        r.m_count = b.m_body();
+        times.push_back(duration<double>(steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    r.m_best = times.front();
+    r.m_median = times[times.size() / 2];
+    return r;
+}
+
+
+void writeText(std::ostream& out, const std::vector<Result>& results)
+{
+    out << std::left << std::setw(20) << "Benchmark" << std::right <<
+        std::setw(10) << "Count" << std::setw(12) << "Best (s)" <<
+        std::setw(12) << "Median (s)" << std::setw(16) << "Rate" << std::endl;
+    for (auto const& r : results)
+    {
+        out << std::left << std::setw(20) << r.m_name << std::right <<
+            std::setw(10) << r.m_count << std::fixed <<
+            std::setprecision(4) << std::setw(12) << r.m_best <<
+            std::setw(12) << r.m_median << std::setprecision(0) <<
+            std::setw(12) << r.rate() << " " << r.m_unit << "/s" <<
+            std::endl;
+        out.unsetf(std::ios_base::floatfield);
+    }
+}
+
+
+void writeJson(std::ostream& out, const Config& config,
+    const std::vector<Result>& results)
+{
+    out << "{" << std::endl;
+    out << "  \"version\": \"" << GetFullVersionString() << "\"," << std::endl;
+    out << "  \"points\": " << config.m_points << "," << std::endl;
+    out << "  \"repeat\": " << config.m_repeat << "," << std::endl;
+    out << "  \"seed\": " << config.m_seed << "," << std::endl;
+    out << "  \"results\": [" << std::endl;
+    out << std::setprecision(9);
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& r = results[i];
+        out << "    { \"name\": \"" << r.m_name << "\", \"unit\": \"" <<
+            r.m_unit << "\", \"count\": " << r.m_count << ", \"best\": " <<
+            r.m_best << ", \"median\": " << r.m_median << ", \"rate\": " <<
+            r.rate() << " }" << (i + 1 < results.size() ? "," : "") <<
+            std::endl;
+    }
+    out << "  ]" << std::endl;
+    out << "}" << std::endl;
+}
+
+
+void usage()
+{
+    std::cerr << "usage: pdal_bench [--points N] [--repeat N] [--seed N] "
+        "[--filter TEXT]\n                  [--tmpdir DIR] [--json FILE] "
+        "[--list]" << std::endl;
+}
+
+
+bool parseArgs(int argc, char *argv[], Config& config)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+        if (arg == "--list")
+        {
+            config.m_list = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            return false;
+        std::string val(argv[++i]);
+        if (arg == "--points")
+            config.m_points = std::strtoull(val.c_str(), NULL, 10);
+        else if (arg == "--repeat")
+            config.m_repeat = std::atoi(val.c_str());
+        else if (arg == "--seed")
+            config.m_seed = (unsigned)std::strtoul(val.c_str(), NULL, 10);
+        else if (arg == "--filter")
+            config.m_filter = val;
+        else if (arg == "--tmpdir")
+            config.m_tmpdir = val;
+        else if (arg == "--json")
+            config.m_json = val;
+        else
+            return false;
+    }
+    return config.m_points > 0 && config.m_repeat > 0;
+}
+
+} // unnamed namespace
+
+
+int main(int argc, char *argv[])
+{
+    Config config;
+    if (!parseArgs(argc, argv, config))
+    {
+        usage();
+        return 1;
+    }
+
+    try
+    {
+        Fixture fixture(config);
+        std::vector<Benchmark> list = benchmarks(fixture, config);
+
+        if (config.m_list)
+        {
+            for (auto const& b : list)
+                std::cout << b.m_name << std::endl;
+            return 0;
+        }
+
+        std::vector<Result> results;
+        for (auto const& b : list)
+            if (b.m_name.find(config.m_filter) != std::string::npos)
+                results.push_back(run(b, config.m_repeat));
+
+        writeText(std::cout, results);
+        if (config.m_json.size())
+        {
+            std::ofstream out(config.m_json);
+            if (!out)
+            {
+                std::cerr << "pdal_bench: can't open '" << config.m_json <<
+                    "' for output." << std::endl;
+                return 1;
+            }
+            writeJson(out, config, results);
+        }
+    }
+    catch (const pdal_error& err)
+    {
+        std::cerr << "pdal_bench: " << err.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
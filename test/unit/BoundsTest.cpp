@@ -126,7 +126,10 @@ TEST(BoundsTest, test_clip)
     EXPECT_FLOAT_EQ(r1.miny, 40);
     EXPECT_FLOAT_EQ(r1.maxy, 8);
 
-//ABELL - Need BOX3D example.
+    // Clipping a 3D box limits each dimension to the overlap.
+    BOX3D b1(0, 0, 0, 10, 10, 10);
+    b1.clip(BOX3D(2, -5, 4, 20, 8, 6));
+    EXPECT_TRUE(b1 == BOX3D(2, 0, 4, 10, 8, 6));
 }
 
 TEST(BoundsTest, test_intersect)
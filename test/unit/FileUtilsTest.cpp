@@ -35,6 +35,7 @@
 #include <pdal/pdal_test_main.hpp>
 
 #include <pdal/util/FileUtils.hpp>
+#include <pdal/util/MappedFile.hpp>
 #include <pdal/util/Utils.hpp>
 
 #include "Support.hpp"
@@ -169,3 +170,26 @@ TEST(FileUtilsTest, filename)
     std::string filename = "/foo//bar//baz.c";
     EXPECT_EQ(FileUtils::getFilename(filename), "baz.c");
 }
+
+TEST(FileUtilsTest, mappedFile)
+{
+    std::string filename = Support::datapath("text/text.txt");
+
+    MappedFile map;
+#ifdef _WIN32
+    EXPECT_FALSE(map.open(filename));
+#else
+    ASSERT_TRUE(map.open(filename));
+    std::string source = FileUtils::readFileIntoString(filename);
+    ASSERT_EQ(map.size(), source.size());
+    EXPECT_EQ(std::string(map.data(), (size_t)map.size()), source);
+
+    // Advice past the end of the file is ignored.
+    map.adviseSequential(0, map.size());
+    map.adviseWillNeed(10, 2 * map.size());
+    map.adviseWillNeed(2 * map.size(), 10);
+    map.close();
+    EXPECT_FALSE(map.isOpen());
+#endif
+    EXPECT_FALSE(map.open(Support::temppath("nonexistent.txt")));
+}
@@ -37,8 +37,11 @@
 #include "Support.hpp"
 
 #include <pdal/PipelineManager.hpp>
+#include <pdal/Trace.hpp>
 #include <pdal/util/FileUtils.hpp>
 
+#include <algorithm>
+
 using namespace pdal;
 
 TEST(PipelineManagerTest, basic)
@@ -71,6 +74,78 @@ TEST(PipelineManagerTest, basic)
 }
 
 
+TEST(PipelineManagerTest, threads)
+{
+    PipelineManager mgr;
+
+    Options optsR;
+    optsR.add("bounds", BOX3D(0, 0, 0, 999, 999, 999));
+    optsR.add("count", 1000);
+    optsR.add("mode", "ramp");
+    Stage& reader = mgr.addReader("readers.faux");
+    reader.setOptions(optsR);
+
+    Options optsC;
+    optsC.add("capacity", 50);
+    Stage& chipper = mgr.addFilter("filters.chipper");
+    chipper.setInput(reader);
+    chipper.setOptions(optsC);
+
+    Options optsT;
+    optsT.add("matrix", "1 0 0 1\n0 1 0 0\n0 0 1 0\n0 0 0 1");
+    Stage& xform = mgr.addFilter("filters.transformation");
+    xform.setInput(chipper);
+    xform.setOptions(optsT);
+
+    mgr.setThreads(4);
+    EXPECT_TRUE(xform.parallelizable());
+    EXPECT_EQ(mgr.execute(), 1000u);
+    EXPECT_EQ(reader.threads(), 4u);
+    EXPECT_GT(mgr.views().size(), 1u);
+
+    std::vector<double> xs;
+    for (auto const& view : mgr.views())
+        for (PointId i = 0; i < view->size(); ++i)
+            xs.push_back(view->getFieldAs<double>(Dimension::Id::X, i));
+    std::sort(xs.begin(), xs.end());
+    ASSERT_EQ(xs.size(), 1000u);
+    for (size_t i = 0; i < xs.size(); ++i)
+        EXPECT_DOUBLE_EQ(xs[i], i + 1.0);
+}
+
+TEST(PipelineManagerTest, threadedBranches)
+{
+    PipelineManager mgr;
+
+    std::vector<Stage *> readers;
+    for (int i = 0; i < 4; ++i)
+    {
+        Options optsR;
+        optsR.add("bounds", BOX3D(0, 0, 0, 9999, 9999, 9999));
+        optsR.add("count", 10000);
+        optsR.add("mode", "ramp");
+        Stage& reader = mgr.addReader("readers.faux");
+        reader.setOptions(optsR);
+        readers.push_back(&reader);
+    }
+
+    Stage& merge = mgr.addFilter("filters.merge");
+    for (Stage *reader : readers)
+        merge.setInput(*reader);
+
+    mgr.setThreads(4);
+    EXPECT_EQ(mgr.execute(), 40000u);
+    ASSERT_EQ(mgr.views().size(), 1u);
+
+    PointViewPtr view = *mgr.views().begin();
+    std::vector<double> xs;
+    for (PointId i = 0; i < view->size(); ++i)
+        xs.push_back(view->getFieldAs<double>(Dimension::Id::X, i));
+    std::sort(xs.begin(), xs.end());
+    for (size_t i = 0; i < xs.size(); ++i)
+        EXPECT_DOUBLE_EQ(xs[i], (double)(i / 4));
+}
+
 //ABELL - Mosaic
 /**
 TEST(PipelineManagerTest, PipelineManagerTest_test2)
@@ -124,3 +199,83 @@ TEST(PipelineManagerTest, PipelineManagerTest_test2)
     FileUtils::deleteFile("temp.las");
 }
 **/
+
+TEST(PipelineManagerTest, profile)
+{
+    PipelineManager mgr;
+
+    Options optsR;
+    optsR.add("bounds", BOX3D(0, 0, 0, 999, 999, 999));
+    optsR.add("count", 1000);
+    optsR.add("mode", "ramp");
+    Stage& reader = mgr.addReader("readers.faux");
+    reader.setOptions(optsR);
+
+    Options optsD;
+    optsD.add("step", 10);
+    Stage& decimate = mgr.addFilter("filters.decimation");
+    decimate.setInput(reader);
+    decimate.setOptions(optsD);
+
+    EXPECT_EQ(mgr.execute(), 100u);
+
+    const StageProfile& r = reader.profile();
+    EXPECT_EQ(r.m_pointsIn, 0u);
+    EXPECT_EQ(r.m_pointsOut, 1000u);
+    EXPECT_GT(r.m_bytesAllocated, 0u);
+    const StageProfile& d = decimate.profile();
+    EXPECT_EQ(d.m_pointsIn, 1000u);
+    EXPECT_EQ(d.m_pointsOut, 100u);
+    EXPECT_EQ(d.m_viewsIn, 1u);
+    EXPECT_EQ(d.m_viewsOut, 1u);
+    EXPECT_EQ(d.m_bytesAllocated, 0u);
+    EXPECT_GE(d.m_wallTime, 0.0);
+    EXPECT_FALSE(d.m_fused);
+
+    MetadataNode m = decimate.getMetadata().findChild("profile");
+    EXPECT_EQ(m.findChild("points_out").value<point_count_t>(), 100u);
+
+    std::ostringstream out;
+    mgr.writeProfile(out);
+    EXPECT_NE(out.str().find("filters.decimation"), std::string::npos);
+}
+
+TEST(PipelineManagerTest, trace)
+{
+    PipelineManager mgr;
+
+    Options optsR;
+    optsR.add("bounds", BOX3D(0, 0, 0, 999, 999, 999));
+    optsR.add("count", 1000);
+    optsR.add("mode", "ramp");
+    Stage& reader = mgr.addReader("readers.faux");
+    reader.setOptions(optsR);
+
+    Options optsD;
+    optsD.add("step", 10);
+    Stage& decimate = mgr.addFilter("filters.decimation");
+    decimate.setInput(reader);
+    decimate.setOptions(optsD);
+
+    Trace::start();
+    EXPECT_EQ(mgr.execute(), 100u);
+    Trace::stop();
+
+    std::ostringstream out;
+    Trace::write(out);
+    std::string trace = out.str();
+    EXPECT_EQ(trace.find("{\"traceEvents\":["), 0u);
+    EXPECT_NE(trace.find("\"name\":\"readers.faux\",\"cat\":\"prepare\""),
+        std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"filters.decimation\",\"cat\":\"run\""),
+        std::string::npos);
+    EXPECT_NE(trace.find("\"args\":{\"name\":\"main\"}"), std::string::npos);
+
+    // Nothing is recorded once tracing is stopped.
+    {
+        TraceScope scope("run", "after stop");
+    }
+    std::ostringstream out2;
+    Trace::write(out2);
+    EXPECT_EQ(out2.str(), trace);
+}
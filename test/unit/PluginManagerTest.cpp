@@ -0,0 +1,268 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/PluginManager.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/Utils.hpp>
+
+#include "Support.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace pdal
+{
+
+// Each tester has its own plugin manager, so the manifest is checked
+// again for each.
+class PluginManagerTester
+{
+public:
+    PluginManagerTester() : m_pm(new PluginManager)
+        {}
+    ~PluginManagerTester()
+        { delete m_pm; }
+
+    bool readManifest(const std::string& filename)
+        { return m_pm->readManifest(filename); }
+    bool loadByManifest(const std::string& driver)
+        { return m_pm->loadByManifest(driver); }
+
+    // Plugin libraries that the manager tried to load.
+    std::vector<std::string> libraries()
+    {
+        std::vector<std::string> libs;
+        for (auto const& lib : m_pm->m_libraryDrivers)
+            libs.push_back(lib.first);
+        return libs;
+    }
+
+private:
+    PluginManager *m_pm;
+};
+
+} // namespace pdal
+
+using namespace pdal;
+
+namespace
+{
+
+#if defined(__APPLE__) && defined(__MACH__)
+const std::string libExtension(".dylib");
+#elif defined _WIN32
+const std::string libExtension(".dll");
+#else
+const std::string libExtension(".so");
+#endif
+
+std::vector<std::string> readLines(const std::string& filename)
+{
+    std::vector<std::string> lines;
+    std::ifstream in(filename);
+    std::string line;
+    while (std::getline(in, line))
+        lines.push_back(line);
+    return lines;
+}
+
+void writeLines(const std::string& filename,
+    const std::vector<std::string>& lines)
+{
+    std::ofstream out(filename);
+    for (auto const& line : lines)
+        out << line << std::endl;
+}
+
+// Replace the time in the "dir" or "lib" line for 'path'.
+std::vector<std::string> setTime(std::vector<std::string> lines,
+    const std::string& key, const std::string& path)
+{
+    for (auto& line : lines)
+        if (Utils::startsWith(line, key + " ") &&
+                line.substr(line.find(' ', key.size() + 1) + 1) == path)
+            line = key + " 1 " + path;
+    return lines;
+}
+
+} // unnamed namespace
+
+TEST(PluginManagerTest, manifest)
+{
+    std::string dir = Support::temppath("plugins");
+    std::string filename = Support::temppath("plugins.manifest");
+    FileUtils::createDirectory(dir);
+    FileUtils::deleteFile(filename);
+
+    // putenv() keeps the strings, so they must outlive the test.
+    static std::string driverPath("PDAL_DRIVER_PATH=" + dir);
+    static std::string manifestPath("PDAL_PLUGIN_MANIFEST=" + filename);
+    Utils::putenv(driverPath.c_str());
+    Utils::putenv(manifestPath.c_str());
+    EXPECT_EQ(PluginManager::manifestFilename(), filename);
+
+    // Looking up an unknown driver writes the manifest of the (empty)
+    // plugin directory and doesn't find the driver.
+    PluginManager& pm = PluginManager::getInstance();
+    EXPECT_EQ(pm.createObject("filters.nosuchfilter"), (void *)NULL);
+    EXPECT_TRUE(FileUtils::fileExists(filename));
+
+    std::ifstream in(filename);
+    std::string line;
+    std::getline(in, line);
+    EXPECT_EQ(line.find("# PDAL plugin manifest"), 0u);
+    std::getline(in, line);
+    EXPECT_EQ(line, "path " + dir);
+    std::getline(in, line);
+    EXPECT_EQ(line.find("dir "), 0u);
+    EXPECT_FALSE(std::getline(in, line));
+    in.close();
+
+    FileUtils::deleteFile(filename);
+    FileUtils::deleteDirectory(dir);
+}
+
+TEST(PluginManagerTest, manifestChecks)
+{
+    std::string dir = Support::temppath("plugins");
+    std::string newDir = Support::temppath("plugins_new");
+    std::string filename = Support::temppath("plugins.manifest");
+    FileUtils::deleteDirectory(newDir);
+    FileUtils::createDirectory(dir);
+    FileUtils::deleteFile(filename);
+
+    // The plugins can't be loaded, but the manager notes each library it
+    // tries.
+    std::string one(dir + "/libpdal_plugin_filter_one" + libExtension);
+    std::string two(dir + "/libpdal_plugin_filter_two" + libExtension);
+    std::string gone(dir + "/libpdal_plugin_filter_gone" + libExtension);
+    writeLines(one, { "not a library" });
+    writeLines(two, { "not a library" });
+
+    static std::string driverPath("PDAL_DRIVER_PATH=" + dir + ":" + newDir);
+    static std::string manifestPath("PDAL_PLUGIN_MANIFEST=" + filename);
+    Utils::putenv(driverPath.c_str());
+    Utils::putenv(manifestPath.c_str());
+
+    // Without a manifest, every library is tried to build one.
+    {
+        PluginManagerTester tester;
+        EXPECT_FALSE(tester.loadByManifest("filters.one"));
+        EXPECT_EQ(tester.libraries().size(), 2u);
+    }
+    std::vector<std::string> built = readLines(filename);
+    ASSERT_EQ(built.size(), 5u);
+    EXPECT_EQ(built[1], "path " + dir + ":" + newDir);
+    EXPECT_EQ(built[2].find("dir "), 0u);
+    EXPECT_EQ(built[3].find("lib "), 0u);
+    EXPECT_EQ(built[4].find("lib "), 0u);
+
+    // Only the library listed for a driver is loaded, and a driver that
+    // isn't listed or whose library is missing isn't found.
+    std::vector<std::string> good(built);
+    good.push_back("driver filters.gone " + gone);
+    good.push_back("driver filters.one " + one);
+    writeLines(filename, good);
+    {
+        PluginManagerTester tester;
+        EXPECT_TRUE(tester.readManifest(filename));
+    }
+    {
+        PluginManagerTester tester;
+        EXPECT_FALSE(tester.loadByManifest("filters.one"));
+        EXPECT_EQ(tester.libraries(), std::vector<std::string>{ one });
+        EXPECT_FALSE(tester.loadByManifest("filters.two"));
+        EXPECT_EQ(tester.libraries(), std::vector<std::string>{ one });
+    }
+    {
+        PluginManagerTester tester;
+        EXPECT_FALSE(tester.loadByManifest("filters.gone"));
+        EXPECT_EQ(tester.libraries(), std::vector<std::string>{ gone });
+    }
+    EXPECT_EQ(readLines(filename), good);
+
+    // A manifest for a different search path or with a changed directory
+    // or library is out of date.
+    std::vector<std::string> stale(good);
+    stale[1] = "path " + dir;
+    writeLines(filename, stale);
+    {
+        PluginManagerTester tester;
+        EXPECT_FALSE(tester.readManifest(filename));
+    }
+    writeLines(filename, setTime(good, "dir", dir));
+    {
+        PluginManagerTester tester;
+        EXPECT_FALSE(tester.readManifest(filename));
+    }
+    writeLines(filename, setTime(good, "lib", one));
+    {
+        PluginManagerTester tester;
+        EXPECT_FALSE(tester.readManifest(filename));
+    }
+
+    // A stale manifest is rebuilt when a driver is looked up.
+    {
+        PluginManagerTester tester;
+        EXPECT_FALSE(tester.loadByManifest("filters.one"));
+        EXPECT_EQ(tester.libraries().size(), 2u);
+    }
+    EXPECT_EQ(readLines(filename), built);
+
+    // A plugin directory created since the manifest was written may hold
+    // unlisted plugins.
+    FileUtils::createDirectory(newDir);
+    {
+        PluginManagerTester tester;
+        EXPECT_FALSE(tester.readManifest(filename));
+    }
+    {
+        PluginManagerTester tester;
+        EXPECT_FALSE(tester.loadByManifest("filters.one"));
+    }
+    std::vector<std::string> rebuilt = readLines(filename);
+    ASSERT_EQ(rebuilt.size(), 6u);
+    EXPECT_EQ(rebuilt[3].find("dir "), 0u);
+    {
+        PluginManagerTester tester;
+        EXPECT_TRUE(tester.readManifest(filename));
+    }
+
+    FileUtils::deleteFile(filename);
+    FileUtils::deleteDirectory(dir);
+    FileUtils::deleteDirectory(newDir);
+}
@@ -34,6 +34,10 @@
 
 #include <pdal/pdal_test_main.hpp>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include <pdal/PointTable.hpp>
 #include <las/LasReader.hpp>
 #include "Support.hpp"
@@ -176,3 +180,164 @@ TEST(PointTable, userView)
     EXPECT_TRUE(called);
 }
 
+
+TEST(PointTable, columns)
+{
+    using namespace Dimension;
+
+    ColumnPointTable table;
+    PointLayoutPtr layout(table.layout());
+    layout->registerDim(Id::X);
+    layout->registerDim(Id::Y);
+    layout->registerDim(Id::Intensity);
+
+    const point_count_t count = 100000;
+    PointView view(table);
+    for (PointId i = 0; i < count; ++i)
+    {
+        view.setField(Id::X, i, i * 2.0);
+        view.setField(Id::Y, i, i * 3.0);
+        view.setField(Id::Intensity, i, (uint16_t)(i % 1000));
+    }
+    EXPECT_TRUE(view.getPoint(0) == NULL);
+
+    for (PointId i = 0; i < count; i += 99)
+    {
+        EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Id::X, i), i * 2.0);
+        EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Id::Y, i), i * 3.0);
+        EXPECT_EQ(view.getFieldAs<uint16_t>(Id::Intensity, i), i % 1000);
+    }
+
+    // Walk the X column a run at a time.
+    point_count_t total = 0;
+    PointId idx = 0;
+    while (true)
+    {
+        point_count_t run;
+        double *x = table.column<double>(Id::X, idx, run);
+        if (!run)
+            break;
+        for (point_count_t i = 0; i < run; ++i)
+            EXPECT_DOUBLE_EQ(x[i], (idx + i) * 2.0);
+        idx += run;
+        total += run;
+    }
+    EXPECT_EQ(total, count);
+
+    point_count_t run;
+    uint16_t *intensity = table.column<uint16_t>(Id::Intensity, 65530, run);
+    EXPECT_EQ(run, 6u);
+    EXPECT_EQ(intensity[5], 535);
+
+    EXPECT_THROW(table.column<float>(Id::X, 0, run), pdal_error);
+}
+
+TEST(PointTable, blocks)
+{
+    using namespace Dimension;
+
+    EXPECT_THROW(PointTable(1000), pdal_error);
+    EXPECT_THROW(PointTable(512), pdal_error);
+
+    // Fill a table, then check that blocks reused from the pool by a
+    // second table are cleared.
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        PointTable table(1024);
+        table.setHugePages(true);
+        EXPECT_EQ(table.blockPtCnt(), 1024u);
+        table.layout()->registerDim(Id::X);
+        table.layout()->registerDim(Id::Y);
+
+        PointView view(table);
+        for (PointId i = 0; i < 5000; ++i)
+            view.setField(Id::X, i, i + 1.0);
+        for (PointId i = 0; i < 5000; ++i)
+        {
+            EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Id::X, i), i + 1.0);
+            EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Id::Y, i), 0.0);
+            view.setField(Id::Y, i, 5.0);
+        }
+    }
+}
+
+// A layout with no dimensions has nothing to store, but points can still
+// be added to it.
+TEST(PointTable, emptyLayout)
+{
+    PointTable table;
+    table.layout()->finalize();
+    EXPECT_EQ(table.layout()->pointSize(), 0u);
+
+    PointView view(table);
+    view.addPoints(5000);
+    view.addPoints(10);
+    EXPECT_EQ(view.size(), 5010u);
+
+#ifndef _WIN32
+    MappedPointTable mapped(Support::temppath());
+    mapped.layout()->finalize();
+
+    PointView mappedView(mapped);
+    mappedView.addPoints(300000);
+    EXPECT_EQ(mappedView.size(), 300000u);
+#endif
+}
+
+#ifndef _WIN32
+TEST(PointTable, mapped)
+{
+    using namespace Dimension;
+
+    // Use a budget smaller than the data so that blocks get released.
+    MappedPointTable table(Support::temppath(), 1024 * 1024);
+    PointLayoutPtr layout(table.layout());
+    layout->registerDim(Id::X);
+    layout->registerDim(Id::Y);
+
+    const point_count_t count = 300000;
+    PointView view(table);
+    for (PointId i = 0; i < count; ++i)
+    {
+        view.setField(Id::X, i, i * 2.0);
+        view.setField(Id::Y, i, i * 3.0);
+    }
+    EXPECT_EQ(view.size(), count);
+
+    for (PointId i = 0; i < count; ++i)
+    {
+        EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Id::X, i), i * 2.0);
+        EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Id::Y, i), i * 3.0);
+    }
+    // Blocks read back in count against the budget.  A block is 1MB.
+    EXPECT_LE(table.residentSize(), (size_t)1024 * 1024);
+
+    // Points read from several threads, out of order, are still correct
+    // and still within the budget.
+    std::vector<std::thread> threads;
+    std::atomic<int> errors(0);
+    for (PointId t = 0; t < 4; ++t)
+        threads.push_back(std::thread([&view, &errors, count, t]()
+        {
+            for (PointId i = t; i < count; i += 7)
+            {
+                PointId j = count - 1 - i;
+                if (view.getFieldAs<double>(Id::X, j) != j * 2.0)
+                    errors++;
+            }
+        }));
+    for (auto& t : threads)
+        t.join();
+    EXPECT_EQ(errors, 0);
+    EXPECT_LE(table.residentSize(), (size_t)1024 * 1024);
+}
+
+TEST(PointTable, mappedBadDir)
+{
+    MappedPointTable table("/this/directory/does/not/exist");
+    table.layout()->registerDim(Dimension::Id::X);
+
+    PointView view(table);
+    EXPECT_THROW(view.setField(Dimension::Id::X, 0, 1.0), pdal_error);
+}
+#endif
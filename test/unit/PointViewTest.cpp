@@ -35,6 +35,7 @@
 #include <pdal/pdal_test_main.hpp>
 
 #include <random>
+#include <thread>
 
 #include <boost/property_tree/xml_parser.hpp>
 
@@ -446,3 +447,201 @@ TEST(PointViewTest, order)
         pi = si;
     }
 }
+
+TEST(PointViewTest, index)
+{
+    PointIndex index;
+
+    // Adding sequential IDs keeps the index as a range.
+    for (PointId id = 10; id < 20; ++id)
+        index.push_back(id);
+    EXPECT_TRUE(index.contiguous());
+    EXPECT_EQ(index.size(), 10u);
+    EXPECT_EQ(index.start(), 10u);
+    EXPECT_EQ(index[5], 15u);
+
+    // Setting an entry to its current value doesn't expand the index.
+    index.set(3, 13);
+    EXPECT_TRUE(index.contiguous());
+
+    PointIndex other;
+    for (PointId id = 20; id < 25; ++id)
+        other.push_back(id);
+    index.insert(index.size(), other, 0, other.size());
+    EXPECT_TRUE(index.contiguous());
+    EXPECT_EQ(index.size(), 15u);
+    EXPECT_EQ(index[14], 24u);
+
+    // Reordering switches to explicit IDs.
+    index.set(0, 24);
+    index.set(14, 10);
+    EXPECT_FALSE(index.contiguous());
+    EXPECT_EQ(index.size(), 15u);
+    EXPECT_EQ(index[0], 24u);
+    EXPECT_EQ(index[1], 11u);
+    EXPECT_EQ(index[14], 10u);
+
+    // Inserting a range into an explicit index.
+    index.insert(1, other, 0, 2);
+    EXPECT_EQ(index.size(), 17u);
+    EXPECT_EQ(index[1], 20u);
+    EXPECT_EQ(index[2], 21u);
+    EXPECT_EQ(index[3], 11u);
+
+    // Adding a non-sequential ID switches to explicit IDs.
+    PointIndex gap;
+    gap.push_back(0);
+    gap.push_back(1);
+    gap.push_back(5);
+    EXPECT_FALSE(gap.contiguous());
+    EXPECT_EQ(gap[1], 1u);
+    EXPECT_EQ(gap[2], 5u);
+}
+
+TEST(PointViewTest, bulk)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Intensity);
+
+    PointView view(table);
+    EXPECT_EQ(view.addPoints(100000), 0u);
+    EXPECT_EQ(view.size(), 100000u);
+    EXPECT_EQ(view.addPoints(10), 100000u);
+    EXPECT_EQ(view.size(), 100010u);
+    for (PointId i = 0; i < view.size(); ++i)
+    {
+        EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Id::X, i), 0.0);
+        view.setField(Id::X, i, (double)i);
+        view.setField(Id::Intensity, i, (uint16_t)(i % 100));
+    }
+
+    PointView part(table);
+    part.append(view, 50, 20);
+    part.append(view, 10, 5);
+    EXPECT_EQ(part.size(), 25u);
+    EXPECT_DOUBLE_EQ(part.getFieldAs<double>(Id::X, 0), 50.0);
+    EXPECT_DOUBLE_EQ(part.getFieldAs<double>(Id::X, 19), 69.0);
+    EXPECT_DOUBLE_EQ(part.getFieldAs<double>(Id::X, 20), 10.0);
+
+    // Identical layouts are copied as packed points.
+    PointTable same;
+    same.layout()->registerDim(Id::X);
+    same.layout()->registerDim(Id::Intensity);
+    EXPECT_TRUE(same.layout()->equal(*table.layout()));
+
+    PointView sameView(same);
+    sameView.copyPoints(view, 0, view.size());
+    sameView.copyPoints(part, 0, part.size());
+    EXPECT_EQ(sameView.size(), view.size() + part.size());
+    for (PointId i = 0; i < view.size(); i += 7)
+    {
+        EXPECT_DOUBLE_EQ(sameView.getFieldAs<double>(Id::X, i), (double)i);
+        EXPECT_EQ(sameView.getFieldAs<uint16_t>(Id::Intensity, i), i % 100);
+    }
+    EXPECT_DOUBLE_EQ(
+        sameView.getFieldAs<double>(Id::X, view.size() + 20), 10.0);
+
+    // Different layouts are copied field by field.
+    PointTable other;
+    other.layout()->registerDim(Id::Intensity, Type::Signed32);
+    other.layout()->registerDim(Id::Z);
+    EXPECT_FALSE(other.layout()->equal(*table.layout()));
+
+    PointView otherView(other);
+    otherView.copyPoints(view, 1000, 500);
+    EXPECT_EQ(otherView.size(), 500u);
+    for (PointId i = 0; i < otherView.size(); ++i)
+    {
+        EXPECT_EQ(otherView.getFieldAs<int32_t>(Id::Intensity, i),
+            (int32_t)((i + 1000) % 100));
+        EXPECT_DOUBLE_EQ(otherView.getFieldAs<double>(Id::Z, i), 0.0);
+    }
+}
+
+TEST(PointViewTest, select)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+
+    PointViewPtr view(new PointView(table));
+    view->addPoints(10000);
+    for (PointId i = 0; i < view->size(); ++i)
+        view->setField(Id::X, i, (double)i);
+
+    PointViewPtr even = view->select([](PointId i){ return i % 2 == 0; });
+    EXPECT_EQ(even->size(), 5000u);
+    for (PointId i = 0; i < even->size(); ++i)
+        EXPECT_DOUBLE_EQ(even->getFieldAs<double>(Id::X, i), 2.0 * i);
+    // Random access.
+    EXPECT_DOUBLE_EQ(even->getFieldAs<double>(Id::X, 4321), 8642.0);
+    EXPECT_DOUBLE_EQ(even->getFieldAs<double>(Id::X, 17), 34.0);
+
+    // Selections of selections refer to the original points.
+    PointViewPtr fours = even->select([](PointId i){ return i % 2 == 0; });
+    EXPECT_EQ(fours->size(), 2500u);
+    EXPECT_DOUBLE_EQ(fours->getFieldAs<double>(Id::X, 2499), 9996.0);
+    EXPECT_DOUBLE_EQ(fours->getFieldAs<double>(Id::X, 3), 12.0);
+
+    // A few points are kept as a list.
+    PointViewPtr few = fours->select([](PointId i){ return i % 1000 == 1; });
+    EXPECT_EQ(few->size(), 3u);
+    EXPECT_DOUBLE_EQ(few->getFieldAs<double>(Id::X, 0), 4.0);
+    EXPECT_DOUBLE_EQ(few->getFieldAs<double>(Id::X, 2), 8004.0);
+
+    PointViewPtr all = view->select([](PointId){ return true; });
+    EXPECT_EQ(all->size(), view->size());
+    PointViewPtr none = view->select([](PointId){ return false; });
+    EXPECT_EQ(none->size(), 0u);
+
+    // Reordering a selection leaves the source view alone.
+    std::sort(even->begin(), even->end(),
+        [](const PointRef& p1, const PointRef& p2)
+        { return p2.compare(Id::X, p1); });
+    EXPECT_DOUBLE_EQ(even->getFieldAs<double>(Id::X, 0), 9998.0);
+    EXPECT_DOUBLE_EQ(even->getFieldAs<double>(Id::X, 4999), 0.0);
+    EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Id::X, 2), 2.0);
+    EXPECT_DOUBLE_EQ(fours->getFieldAs<double>(Id::X, 1), 4.0);
+}
+
+// A selection can be read from several threads at once, each in its own
+// order.
+TEST(PointViewTest, selectThreads)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+
+    PointViewPtr view(new PointView(table));
+    view->addPoints(100000);
+    for (PointId i = 0; i < view->size(); ++i)
+        view->setField(Id::X, i, (double)i);
+    PointViewPtr odd = view->select([](PointId i){ return i % 2 == 1; });
+    ASSERT_EQ(odd->size(), 50000u);
+
+    const size_t NumThreads = 4;
+    std::vector<point_count_t> errors(NumThreads);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < NumThreads; ++t)
+        threads.push_back(std::thread([&odd, &errors, t]()
+        {
+            // Each thread reads every point, starting at a different place
+            // and stepping by a different amount that's prime to the size.
+            const PointId steps[] = { 1, 3, 7, 9 };
+            point_count_t size = odd->size();
+            PointId step = steps[t];
+            PointId i = t * 997 % size;
+            for (point_count_t n = 0; n < size; ++n, i = (i + step) % size)
+                if (odd->getFieldAs<double>(Id::X, i) != 2.0 * i + 1)
+                    errors[t]++;
+        }));
+    for (auto& t : threads)
+        t.join();
+    for (size_t t = 0; t < NumThreads; ++t)
+        EXPECT_EQ(errors[t], 0u);
+}
@@ -34,10 +34,14 @@
 
 #include <pdal/pdal_test_main.hpp>
 
+#include <memory>
+#include <set>
+
 #include <pdal/PointView.hpp>
 #include <pdal/StageFactory.hpp>
 #include <FauxReader.hpp>
 #include <RangeFilter.hpp>
+#include <StatsFilter.hpp>
 
 using namespace pdal;
 
@@ -308,3 +312,115 @@ TEST(RangeFilterTest, negativeValues)
     EXPECT_FLOAT_EQ(1.0, view->getFieldAs<double>(Dimension::Id::Z, 2));
 }
 
+
+// Filters that process points one at a time are run in a single pass.
+TEST(RangeFilterTest, fused)
+{
+    BOX3D srcBounds(0.0, 0.0, 1.0, 0.0, 0.0, 10.0);
+
+    Options ops;
+    ops.add("bounds", srcBounds);
+    ops.add("mode", "ramp");
+    ops.add("num_points", 10);
+
+    FauxReader reader;
+    reader.setOptions(ops);
+
+    StageFactory f;
+    Stage *xform = f.createStage("filters.transformation");
+    Options xformOps;
+    xformOps.add("matrix", "1 0 0 0\n0 1 0 0\n0 0 1 1\n0 0 0 1");
+    xform->setOptions(xformOps);
+    xform->setInput(reader);
+
+    Options range;
+    range.add("min", 4);
+    range.add("max", 6);
+    Option dim("dimension", "Z");
+    dim.setOptions(range);
+    Options rangeOps;
+    rangeOps.add(dim);
+
+    RangeFilter filter;
+    filter.setOptions(rangeOps);
+    filter.setInput(*xform);
+
+    StatsFilter stats;
+    stats.setInput(filter);
+
+    PointTable table;
+    stats.prepare(table);
+    PointViewSet viewSet = stats.execute(table);
+    PointViewPtr view = *viewSet.begin();
+
+    EXPECT_EQ(1u, viewSet.size());
+    EXPECT_EQ(3u, view->size());
+    EXPECT_FLOAT_EQ(4.0, view->getFieldAs<double>(Dimension::Id::Z, 0));
+    EXPECT_FLOAT_EQ(6.0, view->getFieldAs<double>(Dimension::Id::Z, 2));
+
+    EXPECT_EQ(stats.getStats(Dimension::Id::Z).count(), 3u);
+    EXPECT_FLOAT_EQ(stats.getStats(Dimension::Id::Z).minimum(), 4.0);
+}
+
+
+// Fused filters run separate views on separate threads, with the same
+// result as when they're run on a single thread.
+TEST(RangeFilterTest, fusedThreads)
+{
+    auto run = [](size_t threads)
+    {
+        Options ops;
+        ops.add("bounds", BOX3D(0, 0, 0, 100, 100, 10));
+        ops.add("mode", "random");
+        ops.add("num_points", 10000);
+
+        FauxReader reader;
+        reader.setOptions(ops);
+
+        StageFactory f;
+        std::unique_ptr<Stage> splitter(f.createStage("filters.splitter"));
+        Options splitOps;
+        splitOps.add("length", 25);
+        splitter->setOptions(splitOps);
+        splitter->setInput(reader);
+
+        std::unique_ptr<Stage> xform(f.createStage("filters.transformation"));
+        Options xformOps;
+        xformOps.add("matrix", "1 0 0 0\n0 1 0 0\n0 0 1 1\n0 0 0 1");
+        xform->setOptions(xformOps);
+        xform->setInput(*splitter);
+
+        Options range;
+        range.add("min", 4);
+        range.add("max", 6);
+        Option dim("dimension", "Z");
+        dim.setOptions(range);
+        Options rangeOps;
+        rangeOps.add(dim);
+
+        RangeFilter filter;
+        filter.setOptions(rangeOps);
+        filter.setInput(*xform);
+        filter.setThreads(threads);
+
+        PointTable table;
+        filter.prepare(table);
+        PointViewSet viewSet = filter.execute(table);
+        EXPECT_GT(viewSet.size(), 1u);
+
+        std::multiset<double> zs;
+        for (auto const& view : viewSet)
+            for (PointId i = 0; i < view->size(); ++i)
+            {
+                double z = view->getFieldAs<double>(Dimension::Id::Z, i);
+                EXPECT_GE(z, 4.0);
+                EXPECT_LE(z, 6.0);
+                zs.insert(z);
+            }
+        return zs;
+    };
+
+    std::multiset<double> single = run(1);
+    EXPECT_GT(single.size(), 0u);
+    EXPECT_TRUE(single == run(4));
+}
@@ -37,6 +37,7 @@
 #include <TransformationFilter.hpp>
 
 #include <pdal/StageFactory.hpp>
+#include <pdal/util/Utils.hpp>
 
 
 namespace pdal
@@ -171,4 +172,50 @@ TEST_F(TransformationFilterTest, Rotation)
 }
 
 
+// Points stored in columns are transformed the same as packed points.
+TEST(TransformationFilterTest, columns)
+{
+    auto run = [](PointTable& table)
+    {
+        Utils::random_seed(1);
+        Options readerOpts;
+        readerOpts.add("mode", "random");
+        readerOpts.add("num_points", 100000);
+        readerOpts.add("bounds", BOX3D(0, 0, 0, 100, 100, 100));
+        FauxReader reader;
+        reader.setOptions(readerOpts);
+
+        Options filterOpts;
+        filterOpts.add("matrix", "0 1 0 5\n-1 0 0 6\n0 0 2 7\n0 0 0 1");
+        TransformationFilter filter;
+        filter.setOptions(filterOpts);
+        filter.setInput(reader);
+
+        filter.prepare(table);
+        PointViewSet viewSet = filter.execute(table);
+        EXPECT_EQ(1u, viewSet.size());
+        return *viewSet.begin();
+    };
+
+    PointTable table;
+    PointViewPtr packed = run(table);
+    ColumnPointTable columnTable;
+    PointViewPtr columns = run(columnTable);
+
+    point_count_t count;
+    EXPECT_TRUE(columns->column<double>(Dimension::Id::X, 0, count));
+    ASSERT_EQ(100000u, packed->size());
+    ASSERT_EQ(packed->size(), columns->size());
+    for (PointId i = 0; i < packed->size(); ++i)
+    {
+        EXPECT_DOUBLE_EQ(packed->getFieldAs<double>(Dimension::Id::X, i),
+            columns->getFieldAs<double>(Dimension::Id::X, i));
+        EXPECT_DOUBLE_EQ(packed->getFieldAs<double>(Dimension::Id::Y, i),
+            columns->getFieldAs<double>(Dimension::Id::Y, i));
+        EXPECT_DOUBLE_EQ(packed->getFieldAs<double>(Dimension::Id::Z, i),
+            columns->getFieldAs<double>(Dimension::Id::Z, i));
+    }
+}
+
+
 }
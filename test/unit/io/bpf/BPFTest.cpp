@@ -553,3 +553,46 @@ TEST(BPFTest, flex2)
     r.setOptions(ops);
     EXPECT_EQ(r.preview().m_pointCount, 1065u);
 }
+
+TEST(BPFTest, stride)
+{
+    auto readFile = [](const std::string& filename, int stride,
+        PointTable& table)
+    {
+        Options ops;
+        ops.add("filename", filename);
+        ops.add("stride", stride);
+
+        BpfReader reader;
+        reader.setOptions(ops);
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        return *viewSet.begin();
+    };
+
+    std::string filename(
+        Support::datapath("bpf/autzen-utm-chipped-25-v3-interleaved.bpf"));
+
+    PointTable fullTable;
+    PointViewPtr full = readFile(filename, 1, fullTable);
+    PointTable table;
+    PointViewPtr view = readFile(filename, 3, table);
+
+    EXPECT_EQ(view->size(), (full->size() + 2) / 3);
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        EXPECT_FLOAT_EQ(view->getFieldAs<float>(Dimension::Id::X, i),
+            full->getFieldAs<float>(Dimension::Id::X, i * 3));
+        EXPECT_FLOAT_EQ(view->getFieldAs<float>(Dimension::Id::Y, i),
+            full->getFieldAs<float>(Dimension::Id::Y, i * 3));
+        EXPECT_FLOAT_EQ(view->getFieldAs<float>(Dimension::Id::Z, i),
+            full->getFieldAs<float>(Dimension::Id::Z, i * 3));
+    }
+
+    // The stride is ignored for files that aren't point major.
+    PointTable dimTable;
+    PointViewPtr dimView = readFile(
+        Support::datapath("bpf/autzen-utm-chipped-25-v3.bpf"), 3, dimTable);
+    EXPECT_EQ(dimView->size(), full->size());
+}
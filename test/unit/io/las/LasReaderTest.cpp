@@ -34,9 +34,18 @@
 
 #include <pdal/pdal_test_main.hpp>
 
+#include <ctime>
+#include <memory>
+
+#include <boost/filesystem.hpp>
+
 #include <pdal/PointView.hpp>
 #include <pdal/StageFactory.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <FauxReader.hpp>
+#include <LasIndex.hpp>
 #include <LasReader.hpp>
+#include <LasWriter.hpp>
 #include "Support.hpp"
 
 using namespace pdal;
@@ -411,3 +420,557 @@ TEST(LasReaderTest, LasHeaderIncorrentPointcount)
 
     EXPECT_EQ(1064u, view->size());
 }
+
+// Only the dimensions read by later stages are loaded.
+TEST(LasReaderTest, usedDimensions)
+{
+    using namespace Dimension;
+
+    Options ops;
+    ops.add("filename", Support::datapath("las/simple.las"));
+
+    LasReader reader;
+    reader.setOptions(ops);
+
+    StageFactory f;
+    std::unique_ptr<Stage> range(f.createStage("filters.range"));
+    Options limits;
+    limits.add("equals", 2);
+    Option dim("dimension", "Classification");
+    dim.setOptions(limits);
+    Options rangeOps;
+    rangeOps.add(dim);
+    range->setOptions(rangeOps);
+    range->setInput(reader);
+
+    std::unique_ptr<Stage> writer(f.createStage("writers.null"));
+    writer->setInput(*range);
+
+    PointTable table;
+    writer->prepare(table);
+    PointLayoutPtr layout(table.layout());
+    EXPECT_TRUE(layout->hasDim(Id::Classification));
+    EXPECT_FALSE(layout->hasDim(Id::X));
+    EXPECT_FALSE(layout->hasDim(Id::Intensity));
+    EXPECT_FALSE(layout->hasDim(Id::Red));
+    writer->execute(table);
+
+    // Without a writer, the points are returned, so all dimensions are
+    // loaded.
+    LasReader allReader;
+    allReader.setOptions(ops);
+    std::unique_ptr<Stage> allRange(f.createStage("filters.range"));
+    allRange->setOptions(rangeOps);
+    allRange->setInput(allReader);
+
+    PointTable allTable;
+    allRange->prepare(allTable);
+    EXPECT_TRUE(allTable.layout()->hasDim(Id::Intensity));
+    PointViewSet viewSet = allRange->execute(allTable);
+    PointViewPtr view = *viewSet.begin();
+    for (PointId i = 0; i < view->size(); ++i)
+        EXPECT_EQ(view->getFieldAs<int>(Id::Classification, i), 2);
+}
+
+// When no later stage reads any dimension, the location is still loaded
+// so that the points take space in the table.
+TEST(LasReaderTest, noUsedDimensions)
+{
+    using namespace Dimension;
+
+    Options ops;
+    ops.add("filename", Support::datapath("las/simple.las"));
+
+    StageFactory f;
+    LasReader reader;
+    reader.setOptions(ops);
+    std::unique_ptr<Stage> writer(f.createStage("writers.null"));
+    writer->setInput(reader);
+
+    PointTable table;
+    writer->prepare(table);
+    PointLayoutPtr layout(table.layout());
+    EXPECT_TRUE(layout->hasDim(Id::X));
+    EXPECT_TRUE(layout->hasDim(Id::Y));
+    EXPECT_TRUE(layout->hasDim(Id::Z));
+    EXPECT_FALSE(layout->hasDim(Id::Intensity));
+    PointViewSet viewSet = writer->execute(table);
+    EXPECT_EQ((*viewSet.begin())->size(), 1065u);
+
+    LasReader decReader;
+    decReader.setOptions(ops);
+    std::unique_ptr<Stage> decimation(f.createStage("filters.decimation"));
+    Options decOps;
+    decOps.add("step", 10);
+    decimation->setOptions(decOps);
+    decimation->setInput(decReader);
+    std::unique_ptr<Stage> decWriter(f.createStage("writers.null"));
+    decWriter->setInput(*decimation);
+
+    PointTable decTable;
+    decWriter->prepare(decTable);
+    EXPECT_GT(decTable.layout()->pointSize(), 0u);
+    viewSet = decWriter->execute(decTable);
+    EXPECT_EQ((*viewSet.begin())->size(), 107u);
+}
+
+// Points outside the bounds of later stages aren't loaded.
+TEST(LasReaderTest, boundsHint)
+{
+    using namespace Dimension;
+
+    auto test = [](double minx, double maxx, bool some)
+    {
+        Options ops;
+        ops.add("filename", Support::datapath("las/simple.las"));
+
+        point_count_t count = 0;
+        LasReader reader;
+        reader.setOptions(ops);
+        reader.setReadCb([&count](PointView&, PointId){ count++; });
+
+        Options limits;
+        limits.add("min", minx);
+        limits.add("max", maxx);
+        Option dim("dimension", "X");
+        dim.setOptions(limits);
+        Options rangeOps;
+        rangeOps.add(dim);
+
+        StageFactory f;
+        std::unique_ptr<Stage> range(f.createStage("filters.range"));
+        range->setOptions(rangeOps);
+        range->setInput(reader);
+
+        PointTable table;
+        range->prepare(table);
+        PointViewSet viewSet = range->execute(table);
+        point_count_t size = 0;
+        for (auto& view : viewSet)
+        {
+            size += view->size();
+            for (PointId i = 0; i < view->size(); ++i)
+            {
+                double x = view->getFieldAs<double>(Id::X, i);
+                EXPECT_TRUE(x >= minx && x <= maxx);
+            }
+        }
+        EXPECT_EQ(count, size);
+        EXPECT_LT(count, 1065u);
+        EXPECT_EQ(count > 0, some);
+    };
+
+    test(635000, 637000, true);
+    // Outside the header bounds.
+    test(0, 1000, false);
+}
+
+// Points decoded by several threads match those decoded by one.
+TEST(LasReaderTest, threads)
+{
+    using namespace Dimension;
+
+    std::string filename(Support::temppath("threads.las"));
+    FileUtils::deleteFile(filename);
+
+    Options fauxOps;
+    fauxOps.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+    fauxOps.add("num_points", 100000);
+    fauxOps.add("mode", "random");
+    fauxOps.add("number_of_returns", 3);
+
+    FauxReader faux;
+    faux.setOptions(fauxOps);
+
+    Options writerOps;
+    writerOps.add("filename", filename);
+    writerOps.add("minor_version", 2);
+    writerOps.add("dataformat_id", 3);
+    writerOps.add("scale_x", .01);
+    writerOps.add("scale_y", .01);
+    writerOps.add("scale_z", .01);
+
+    LasWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(faux);
+
+    PointTable fauxTable;
+    writer.prepare(fauxTable);
+    writer.execute(fauxTable);
+
+    auto read = [&filename](PointTable& table, int threads)
+    {
+        Options ops;
+        ops.add("filename", filename);
+        ops.add("threads", threads);
+
+        LasReader reader;
+        reader.setOptions(ops);
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        return *viewSet.begin();
+    };
+
+    PointTable table1;
+    PointViewPtr view1 = read(table1, 1);
+    PointTable table4;
+    PointViewPtr view4 = read(table4, 4);
+
+    ASSERT_EQ(view1->size(), 100000u);
+    ASSERT_EQ(view4->size(), view1->size());
+    for (PointId i = 0; i < view1->size(); ++i)
+    {
+        EXPECT_EQ(view1->getFieldAs<double>(Id::X, i),
+            view4->getFieldAs<double>(Id::X, i));
+        EXPECT_EQ(view1->getFieldAs<double>(Id::Y, i),
+            view4->getFieldAs<double>(Id::Y, i));
+        EXPECT_EQ(view1->getFieldAs<double>(Id::Z, i),
+            view4->getFieldAs<double>(Id::Z, i));
+        EXPECT_EQ(view1->getFieldAs<int>(Id::ReturnNumber, i),
+            view4->getFieldAs<int>(Id::ReturnNumber, i));
+        EXPECT_EQ(view1->getFieldAs<double>(Id::GpsTime, i),
+            view4->getFieldAs<double>(Id::GpsTime, i));
+    }
+    FileUtils::deleteFile(filename);
+}
+
+// Points decoded from the mapped file match those read through a stream.
+TEST(LasReaderTest, mmap)
+{
+    using namespace Dimension;
+
+    auto read = [](PointTable& table, bool mmap)
+    {
+        Options ops;
+        ops.add("filename", Support::datapath("las/simple.las"));
+        ops.add("mmap", mmap);
+
+        LasReader reader;
+        reader.setOptions(ops);
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        return *viewSet.begin();
+    };
+
+    PointTable mappedTable;
+    PointViewPtr mapped = read(mappedTable, true);
+    PointTable streamTable;
+    PointViewPtr streamed = read(streamTable, false);
+
+    ASSERT_EQ(mapped->size(), 1065u);
+    ASSERT_EQ(streamed->size(), mapped->size());
+    Dimension::IdList dims = mappedTable.layout()->dims();
+    for (PointId i = 0; i < mapped->size(); ++i)
+        for (auto dim : dims)
+            EXPECT_EQ(mapped->getFieldAs<double>(dim, i),
+                streamed->getFieldAs<double>(dim, i));
+}
+
+// Points stored into a table without packed points, which are set through
+// the view, match those copied directly into the points of a table.
+TEST(LasReaderTest, columns)
+{
+    auto read = [](PointTable& table)
+    {
+        Options ops;
+        ops.add("filename", Support::datapath("las/1.2-with-color.las"));
+
+        LasReader reader;
+        reader.setOptions(ops);
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        return *viewSet.begin();
+    };
+
+    PointTable table;
+    PointViewPtr packed = read(table);
+    ColumnPointTable columnTable;
+    PointViewPtr columns = read(columnTable);
+
+    ASSERT_EQ(packed->size(), 1065u);
+    ASSERT_EQ(columns->size(), packed->size());
+    Dimension::IdList dims = table.layout()->dims();
+    for (PointId i = 0; i < packed->size(); ++i)
+        for (auto dim : dims)
+            EXPECT_EQ(packed->getFieldAs<double>(dim, i),
+                columns->getFieldAs<double>(dim, i));
+}
+
+// A strided read loads every Nth point of a full read.
+TEST(LasReaderTest, stride)
+{
+    auto read = [](PointTable& table, const std::string& file, bool mmap,
+        point_count_t stride)
+    {
+        Options ops;
+        ops.add("filename", Support::datapath(file));
+        ops.add("mmap", mmap);
+        ops.add("stride", stride);
+
+        LasReader reader;
+        reader.setOptions(ops);
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        return *viewSet.begin();
+    };
+
+    auto check = [&read](const std::string& file, bool mmap)
+    {
+        PointTable table;
+        PointViewPtr all = read(table, file, mmap, 1);
+        PointTable stridedTable;
+        PointViewPtr strided = read(stridedTable, file, mmap, 10);
+
+        ASSERT_EQ(all->size(), 1065u);
+        ASSERT_EQ(strided->size(), 107u);
+        Dimension::IdList dims = table.layout()->dims();
+        for (PointId i = 0; i < strided->size(); ++i)
+            for (auto dim : dims)
+                EXPECT_EQ(strided->getFieldAs<double>(dim, i),
+                    all->getFieldAs<double>(dim, i * 10));
+    };
+
+    check("las/simple.las", true);
+    check("las/simple.las", false);
+#ifdef PDAL_HAVE_LASZIP
+    check("laz/simple.laz", false);
+#endif
+}
+
+#ifdef PDAL_HAVE_LAZPERF
+// Chunks decompressed in parallel match those decompressed in order.
+TEST(LasReaderTest, lazperfThreads)
+{
+    using namespace Dimension;
+
+    std::string filename(Support::temppath("lazperf_threads.laz"));
+    FileUtils::deleteFile(filename);
+
+    // Three chunks, the last of them short.
+    Options fauxOps;
+    fauxOps.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+    fauxOps.add("num_points", 120000);
+    fauxOps.add("mode", "random");
+
+    FauxReader faux;
+    faux.setOptions(fauxOps);
+
+    Options writerOps;
+    writerOps.add("filename", filename);
+    writerOps.add("dataformat_id", 1);
+    writerOps.add("compression", "lazperf");
+
+    LasWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(faux);
+
+    PointTable fauxTable;
+    writer.prepare(fauxTable);
+    writer.execute(fauxTable);
+
+    auto read = [&filename](PointTable& table, int threads)
+    {
+        Options ops;
+        ops.add("filename", filename);
+        ops.add("threads", threads);
+        ops.add("compression", "lazperf");
+
+        LasReader reader;
+        reader.setOptions(ops);
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        return *viewSet.begin();
+    };
+
+    PointTable table1;
+    PointViewPtr view1 = read(table1, 1);
+    PointTable table4;
+    PointViewPtr view4 = read(table4, 4);
+
+    ASSERT_EQ(view1->size(), 120000u);
+    ASSERT_EQ(view4->size(), view1->size());
+    for (PointId i = 0; i < view1->size(); ++i)
+        for (auto dim : { Id::X, Id::Y, Id::Z, Id::GpsTime })
+            EXPECT_EQ(view1->getFieldAs<double>(dim, i),
+                view4->getFieldAs<double>(dim, i));
+    FileUtils::deleteFile(filename);
+}
+#endif // PDAL_HAVE_LAZPERF
+
+// Reading with an index loads the same points as scanning the whole file,
+// while reading only part of it.
+TEST(LasReaderTest, index)
+{
+    using namespace Dimension;
+
+    std::string filename(Support::temppath("index.las"));
+    FileUtils::deleteFile(filename);
+    FileUtils::deleteFile(LasIndex::sidecarName(filename));
+
+    // Ramp points are in spatial order, as an index is meant for.
+    Options fauxOps;
+    fauxOps.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+    fauxOps.add("num_points", 200000);
+    fauxOps.add("mode", "ramp");
+
+    FauxReader faux;
+    faux.setOptions(fauxOps);
+
+    Options writerOps;
+    writerOps.add("filename", filename);
+
+    LasWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(faux);
+
+    PointTable fauxTable;
+    writer.prepare(fauxTable);
+    writer.execute(fauxTable);
+
+    BOX2D bounds(300, 300, 350, 350);
+    auto read = [&filename, &bounds](PointTable& table)
+    {
+        Options ops;
+        ops.add("filename", filename);
+        ops.add("bounds", bounds);
+
+        LasReader reader;
+        reader.setOptions(ops);
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        return *viewSet.begin();
+    };
+
+    PointTable scanTable;
+    PointViewPtr scanView = read(scanTable);
+
+    LasIndex::create(filename);
+    LasIndex index;
+    LasReader headerReader;
+    Options headerOps;
+    headerOps.add("filename", filename);
+    headerReader.setOptions(headerOps);
+    PointTable headerTable;
+    headerReader.prepare(headerTable);
+    EXPECT_TRUE(index.load(filename, headerReader.header()));
+    EXPECT_EQ(index.numPoints(), 200000u);
+    point_count_t indexed = 0;
+    for (auto& r : index.ranges(bounds))
+        indexed += r.second - r.first;
+    EXPECT_LT(indexed, 200000u / 4);
+
+    PointTable indexTable;
+    PointViewPtr indexView = read(indexTable);
+
+    EXPECT_GT(scanView->size(), 0u);
+    ASSERT_EQ(indexView->size(), scanView->size());
+    for (PointId i = 0; i < scanView->size(); ++i)
+    {
+        double x = indexView->getFieldAs<double>(Id::X, i);
+        double y = indexView->getFieldAs<double>(Id::Y, i);
+        EXPECT_TRUE(bounds.contains(x, y));
+        EXPECT_EQ(scanView->getFieldAs<double>(Id::X, i), x);
+        EXPECT_EQ(scanView->getFieldAs<double>(Id::Y, i), y);
+    }
+
+    // Ramp points lie along the diagonal, so the index has no points in
+    // these bounds and the file isn't read.
+    bounds = BOX2D(700, 100, 800, 200);
+    PointTable emptyTable;
+    EXPECT_EQ(read(emptyTable)->size(), 0u);
+
+    FileUtils::deleteFile(filename);
+    FileUtils::deleteFile(LasIndex::sidecarName(filename));
+}
+
+// An index is ignored once its file is rewritten, even if the file keeps
+// its size and point count.
+TEST(LasReaderTest, staleIndex)
+{
+    std::string filename(Support::temppath("stale.las"));
+    FileUtils::deleteFile(filename);
+    FileUtils::deleteFile(LasIndex::sidecarName(filename));
+
+    auto write = [&filename](const BOX3D& bounds)
+    {
+        Options fauxOps;
+        fauxOps.add("bounds", bounds);
+        fauxOps.add("num_points", 200000);
+        fauxOps.add("mode", "ramp");
+
+        FauxReader faux;
+        faux.setOptions(fauxOps);
+
+        Options writerOps;
+        writerOps.add("filename", filename);
+
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(faux);
+
+        PointTable table;
+        writer.prepare(table);
+        writer.execute(table);
+    };
+
+    auto loadIndex = [&filename]()
+    {
+        Options ops;
+        ops.add("filename", filename);
+        LasReader reader;
+        reader.setOptions(ops);
+        PointTable table;
+        reader.prepare(table);
+        LasIndex index;
+        return index.load(filename, reader.header());
+    };
+
+    BOX2D bounds(300, 300, 350, 350);
+    auto read = [&filename, &bounds]()
+    {
+        Options ops;
+        ops.add("filename", filename);
+        ops.add("bounds", bounds);
+
+        LasReader reader;
+        reader.setOptions(ops);
+        PointTable table;
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        return (*viewSet.begin())->size();
+    };
+
+    write(BOX3D(0, 0, 0, 1000, 1000, 1000));
+    LasIndex::create(filename);
+    EXPECT_TRUE(loadIndex());
+    uintmax_t size = FileUtils::fileSize(filename);
+    std::time_t modTime = boost::filesystem::last_write_time(filename);
+
+    // Shift the points, keeping the size of the file.  The modification
+    // time is put back so that only the bounds differ.
+    write(BOX3D(300, 300, 0, 1300, 1300, 1000));
+    ASSERT_EQ(FileUtils::fileSize(filename), size);
+    boost::filesystem::last_write_time(filename, modTime);
+    EXPECT_FALSE(loadIndex());
+
+    // The stale index would read the points that used to be in bounds.
+    point_count_t count = read();
+    FileUtils::deleteFile(LasIndex::sidecarName(filename));
+    EXPECT_GT(count, 0u);
+    EXPECT_EQ(count, read());
+
+    // A file that's only touched is stale as well.
+    LasIndex::create(filename);
+    EXPECT_TRUE(loadIndex());
+    boost::filesystem::last_write_time(filename, modTime + 10);
+    EXPECT_FALSE(loadIndex());
+
+    FileUtils::deleteFile(filename);
+    FileUtils::deleteFile(LasIndex::sidecarName(filename));
+}
@@ -38,6 +38,7 @@
 
 #include <pdal/util/FileUtils.hpp>
 #include <pdal/BufferReader.hpp>
+#include <FauxReader.hpp>
 #include <LasHeader.hpp>
 #include <LasReader.hpp>
 #include <LasWriter.hpp>
@@ -461,6 +462,66 @@ TEST(LasWriterTest, flex2)
     EXPECT_EQ(r.preview().m_pointCount, 1065u);
 }
 
+// Points written in streaming mode, a chunk at a time, are the same as
+// those written all at once.
+TEST(LasWriterTest, stream)
+{
+    std::string infile(Support::datapath("las/1.2-with-color.las"));
+    std::string outfile(Support::temppath("simple_stream.las"));
+    std::string reffile(Support::temppath("simple_nostream.las"));
+
+    Options readerOpts;
+    readerOpts.add("filename", infile);
+
+    auto writerOpts = [](const std::string& filename)
+    {
+        FileUtils::deleteFile(filename);
+
+        Options ops;
+        ops.add("creation_year", 2014);
+        ops.add("filename", filename);
+        return ops;
+    };
+
+    {
+        PointTable table;
+
+        LasReader reader;
+        reader.setOptions(readerOpts);
+
+        LasWriter writer;
+        writer.setOptions(writerOpts(reffile));
+        writer.setInput(reader);
+        writer.prepare(table);
+        writer.execute(table);
+    }
+
+    {
+        // Use a small table so that the points are written over many
+        // chunks.
+        StreamPointTable table(100);
+
+        LasReader reader;
+        reader.setOptions(readerOpts);
+
+        LasWriter writer;
+        writer.setOptions(writerOpts(outfile));
+        writer.setInput(reader);
+        writer.prepare(table);
+        EXPECT_TRUE(writer.pipelineStreamable());
+        writer.execute(table);
+    }
+
+    Options ops;
+    ops.add("filename", outfile);
+    LasReader r;
+    r.setOptions(ops);
+    EXPECT_EQ(r.preview().m_pointCount, 1065u);
+    EXPECT_TRUE(Support::compare_files(reffile, outfile));
+    FileUtils::deleteFile(outfile);
+    FileUtils::deleteFile(reffile);
+}
+
 /**
 namespace
 {
@@ -647,3 +708,265 @@ TEST(LasWriterTest, version1_2)
 }
 **/
 
+
+// Points written in each supported point format read back with the fields
+// of that format intact.
+TEST(LasWriterTest, formats)
+{
+    using namespace Dimension;
+
+    std::string infile(Support::datapath("las/1.2-with-color.las"));
+    std::string outfile(Support::temppath("formats.las"));
+
+    Options readerOps;
+    readerOps.add("filename", infile);
+    LasReader inReader;
+    inReader.setOptions(readerOps);
+
+    PointTable inTable;
+    inReader.prepare(inTable);
+    PointViewSet inSet = inReader.execute(inTable);
+    PointViewPtr inView = *inSet.begin();
+
+    for (int format : { 0, 1, 2, 3, 6, 7, 8 })
+    {
+        FileUtils::deleteFile(outfile);
+
+        BufferReader bufferReader;
+        bufferReader.addView(inView);
+
+        Options writerOps;
+        writerOps.add("filename", outfile);
+        writerOps.add("minor_version", format > 5 ? 4 : 2);
+        writerOps.add("dataformat_id", format);
+
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(bufferReader);
+        writer.prepare(inTable);
+        writer.execute(inTable);
+
+        Options outOps;
+        outOps.add("filename", outfile);
+        LasReader outReader;
+        outReader.setOptions(outOps);
+
+        PointTable outTable;
+        outReader.prepare(outTable);
+        PointViewSet outSet = outReader.execute(outTable);
+        PointViewPtr outView = *outSet.begin();
+        EXPECT_EQ(outReader.header().pointFormat(), format);
+        ASSERT_EQ(outView->size(), inView->size());
+
+        bool hasTime = (format == 1 || format >= 3);
+        bool hasColor = (format == 2 || format == 3 || format >= 7);
+        Dimension::IdList dims { Id::Intensity, Id::ReturnNumber,
+            Id::NumberOfReturns, Id::ScanDirectionFlag, Id::EdgeOfFlightLine,
+            Id::Classification, Id::UserData, Id::PointSourceId };
+        if (hasTime)
+            dims.push_back(Id::GpsTime);
+        if (hasColor)
+        {
+            dims.push_back(Id::Red);
+            dims.push_back(Id::Green);
+            dims.push_back(Id::Blue);
+        }
+        for (PointId i = 0; i < inView->size(); ++i)
+        {
+            for (auto dim : { Id::X, Id::Y, Id::Z })
+                EXPECT_NEAR(inView->getFieldAs<double>(dim, i),
+                    outView->getFieldAs<double>(dim, i), 1e-7);
+            for (auto dim : dims)
+                EXPECT_EQ(inView->getFieldAs<double>(dim, i),
+                    outView->getFieldAs<double>(dim, i));
+            // Scan angles of 1.4 formats are stored in units of .006
+            // degrees.
+            EXPECT_NEAR(inView->getFieldAs<double>(Id::ScanAngleRank, i),
+                outView->getFieldAs<double>(Id::ScanAngleRank, i), .006);
+        }
+    }
+    FileUtils::deleteFile(outfile);
+}
+
+#ifdef PDAL_HAVE_LAZPERF
+TEST(LasWriterTest, lazperf)
+{
+    using namespace Dimension;
+
+    std::string infile(Support::datapath("las/1.2-with-color.las"));
+    std::string outfile(Support::temppath("lazperf.laz"));
+    FileUtils::deleteFile(outfile);
+
+    Options readerOps;
+    readerOps.add("filename", infile);
+    LasReader inReader;
+    inReader.setOptions(readerOps);
+
+    Options writerOps;
+    writerOps.add("filename", outfile);
+    writerOps.add("compression", "lazperf");
+    LasWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(inReader);
+
+    PointTable inTable;
+    writer.prepare(inTable);
+    PointViewSet inSet = writer.execute(inTable);
+    PointViewPtr inView = *inSet.begin();
+
+    // The output must be readable by either library.
+    StringList engines { "lazperf" };
+#ifdef PDAL_HAVE_LASZIP
+    engines.push_back("laszip");
+#endif
+    for (auto& engine : engines)
+    {
+        Options outOps;
+        outOps.add("filename", outfile);
+        outOps.add("compression", engine);
+        LasReader outReader;
+        outReader.setOptions(outOps);
+
+        PointTable outTable;
+        outReader.prepare(outTable);
+        PointViewSet outSet = outReader.execute(outTable);
+        PointViewPtr outView = *outSet.begin();
+        EXPECT_TRUE(outReader.header().compressed());
+        ASSERT_EQ(outView->size(), inView->size());
+
+        for (PointId i = 0; i < inView->size(); ++i)
+            for (auto dim : { Id::X, Id::Y, Id::Z, Id::Intensity,
+                Id::ReturnNumber, Id::Classification, Id::GpsTime,
+                Id::Red, Id::Green, Id::Blue })
+                EXPECT_EQ(inView->getFieldAs<double>(dim, i),
+                    outView->getFieldAs<double>(dim, i));
+    }
+    FileUtils::deleteFile(outfile);
+}
+#endif // PDAL_HAVE_LAZPERF
+
+#ifdef PDAL_HAVE_LAZPERF
+// Chunks compressed in parallel are the same as those compressed in order.
+TEST(LasWriterTest, lazperfThreads)
+{
+    std::string file1(Support::temppath("lazperf_threads1.laz"));
+    std::string file4(Support::temppath("lazperf_threads4.laz"));
+
+    // Enough points for more chunks than threads, the last of them short.
+    // 270000 isn't a multiple of the 200000 points buffered for four
+    // threads of 50000 point chunks, so the last batch is partial too.
+    Options fauxOps;
+    fauxOps.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+    fauxOps.add("num_points", 270000);
+    fauxOps.add("mode", "random");
+    FauxReader faux;
+    faux.setOptions(fauxOps);
+
+    PointTable table;
+    faux.prepare(table);
+    PointViewSet viewSet = faux.execute(table);
+    PointViewPtr view = *viewSet.begin();
+
+    auto write = [&table, &view](const std::string& filename, int threads)
+    {
+        FileUtils::deleteFile(filename);
+
+        BufferReader bufferReader;
+        bufferReader.addView(view);
+
+        Options writerOps;
+        writerOps.add("filename", filename);
+        writerOps.add("compression", "lazperf");
+        writerOps.add("threads", threads);
+
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(bufferReader);
+        writer.prepare(table);
+        writer.execute(table);
+    };
+
+    write(file1, 1);
+    write(file4, 4);
+    EXPECT_TRUE(Support::compare_files(file1, file4));
+
+    // The points compressed in parallel match the source points, to
+    // within the default scale, when read by either library.
+    StringList engines { "lazperf" };
+#ifdef PDAL_HAVE_LASZIP
+    engines.push_back("laszip");
+#endif
+    for (auto& engine : engines)
+    {
+        Options ops;
+        ops.add("filename", file4);
+        ops.add("compression", engine);
+        LasReader reader;
+        reader.setOptions(ops);
+
+        PointTable outTable;
+        reader.prepare(outTable);
+        PointViewSet outSet = reader.execute(outTable);
+        PointViewPtr outView = *outSet.begin();
+        ASSERT_EQ(outView->size(), view->size());
+
+        for (PointId i = 0; i < view->size(); ++i)
+            for (auto dim : { Dimension::Id::X, Dimension::Id::Y,
+                Dimension::Id::Z })
+                EXPECT_NEAR(view->getFieldAs<double>(dim, i),
+                    outView->getFieldAs<double>(dim, i), .0051);
+    }
+    FileUtils::deleteFile(file1);
+    FileUtils::deleteFile(file4);
+}
+#endif // PDAL_HAVE_LAZPERF
+
+// Points written by a background thread are the same as those written in
+// order.
+TEST(LasWriterTest, writeBuffers)
+{
+    std::string file1(Support::temppath("write_buffers1.las"));
+    std::string file3(Support::temppath("write_buffers3.las"));
+
+    // Enough points to fill more buffers than are used and to have the
+    // cache advised more than once.
+    Options fauxOps;
+    fauxOps.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+    fauxOps.add("num_points", 1200000);
+    fauxOps.add("mode", "random");
+    FauxReader faux;
+    faux.setOptions(fauxOps);
+
+    PointTable table;
+    faux.prepare(table);
+    PointViewSet viewSet = faux.execute(table);
+    PointViewPtr view = *viewSet.begin();
+
+    auto write = [&table, &view](const std::string& filename, int buffers,
+        bool dropCache)
+    {
+        FileUtils::deleteFile(filename);
+
+        BufferReader bufferReader;
+        bufferReader.addView(view);
+
+        Options writerOps;
+        writerOps.add("filename", filename);
+        writerOps.add("write_buffers", buffers);
+        writerOps.add("drop_cache", dropCache);
+
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(bufferReader);
+        writer.prepare(table);
+        writer.execute(table);
+    };
+
+    write(file1, 1, false);
+    write(file3, 3, true);
+    EXPECT_TRUE(Support::compare_files(file1, file3));
+    write(file3, 1, true);
+    EXPECT_TRUE(Support::compare_files(file1, file3));
+    FileUtils::deleteFile(file1);
+    FileUtils::deleteFile(file3);
+}
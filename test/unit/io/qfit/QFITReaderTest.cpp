@@ -111,3 +111,43 @@ TEST(QFITReaderTest, test_14_word)
     Check_Point(*view, 1, 244.306260, 35.623280, 1056.409000000, 903);
     Check_Point(*view, 2, 244.306204, 35.623257, 1056.483000000, 903);
 }
+
+TEST(QFITReaderTest, stride)
+{
+    auto readFile = [](int stride, int count, PointTable& table)
+    {
+        Options options;
+
+        options.add("filename", Support::datapath("qfit/10-word.qi"));
+        options.add("flip_coordinates", false);
+        options.add("scale_z", 0.001f);
+        options.add("stride", stride);
+        options.add("count", count);
+
+        QfitReader reader;
+        reader.setOptions(options);
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        return *viewSet.begin();
+    };
+
+    PointTable fullTable;
+    PointViewPtr full = readFile(1, 30, fullTable);
+    EXPECT_EQ(full->size(), 30u);
+
+    // The count limits the number of points read after striding.
+    PointTable table;
+    PointViewPtr view = readFile(4, 5, table);
+    EXPECT_EQ(view->size(), 5u);
+
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        PointId j = i * 4;
+        Check_Point(*view, i,
+            full->getFieldAs<double>(Dimension::Id::X, j),
+            full->getFieldAs<double>(Dimension::Id::Y, j),
+            full->getFieldAs<double>(Dimension::Id::Z, j),
+            full->getFieldAs<int32_t>(Dimension::Id::OffsetTime, j));
+    }
+}
@@ -115,6 +115,25 @@ TEST(SbetReaderTest, testRead)
                7.179027672314571e-02);
 }
 
+TEST(SbetReaderTest, stride)
+{
+    Options options;
+    options.add("filename", Support::datapath("sbet/2-points.sbet"));
+    options.add("stride", 2);
+    SbetReader reader;
+    reader.setOptions(options);
+
+    PointTable table;
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+
+    EXPECT_EQ(view->size(), 1u);
+    EXPECT_FLOAT_EQ(view->getFieldAs<double>(Dimension::Id::GpsTime, 0),
+        1.516310028360710e+05);
+}
+
 TEST(SbetReaderTest, testBadFile)
 {
     Option filename("filename", Support::datapath("sbet/badfile.sbet"), "");
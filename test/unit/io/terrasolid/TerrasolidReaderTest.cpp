@@ -125,4 +125,42 @@ TEST_F(TerrasolidReaderTest, ReadingPoints)
     EXPECT_EQ(0, view->getFieldAs<uint8_t>(Dimension::Id::Flag, 0));
     EXPECT_EQ(0, view->getFieldAs<uint8_t>(Dimension::Id::Mark, 0));
 }
+
+
+TEST_F(TerrasolidReaderTest, stride)
+{
+    Options options;
+    options.add("filename", getTestfilePath());
+    options.add("stride", 7);
+    TerrasolidReader reader;
+    reader.setOptions(options);
+
+    PointTable table;
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), 143u);
+
+    PointTable fullTable;
+    m_reader.prepare(fullTable);
+    viewSet = m_reader.execute(fullTable);
+    PointViewPtr full = *viewSet.begin();
+    EXPECT_EQ(full->size(), 1000u);
+
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        PointId j = i * 7;
+        EXPECT_DOUBLE_EQ(full->getFieldAs<double>(Dimension::Id::X, j),
+            view->getFieldAs<double>(Dimension::Id::X, i));
+        EXPECT_DOUBLE_EQ(full->getFieldAs<double>(Dimension::Id::Y, j),
+            view->getFieldAs<double>(Dimension::Id::Y, i));
+        EXPECT_DOUBLE_EQ(full->getFieldAs<double>(Dimension::Id::Z, j),
+            view->getFieldAs<double>(Dimension::Id::Z, i));
+        EXPECT_EQ(full->getFieldAs<uint16_t>(Dimension::Id::Intensity, j),
+            view->getFieldAs<uint16_t>(Dimension::Id::Intensity, i));
+        EXPECT_EQ(full->getFieldAs<uint8_t>(Dimension::Id::Red, j),
+            view->getFieldAs<uint8_t>(Dimension::Id::Red, i));
+    }
+}
 }